@@ -0,0 +1,81 @@
+#define EVAL_COUNT_ALLOCATIONS
+#include "../include/eval.hpp"
+#include "../include/eval_instrument.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// A batch of distinct user formulas of growing length
+static std::vector<std::string> formulas(std::size_t count)
+{
+    const char *terms[] = {"x*y", "sin(x)", "(y-1.5)^2", "sqrt(x*x+y*y)", "exp(-x)", "2.75/y", "atan2(y, x)"};
+    std::vector<std::string> out;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::string f = std::to_string(i);
+        for (std::size_t j = 0; j <= i % 12; ++j)
+            f += (j % 2 ? " - " : " + ") + std::string(terms[(i + j * 3) % 7]);
+        out.push_back(f);
+    }
+    return out;
+}
+
+struct Result
+{
+    double ns_per_formula;
+    double allocations_per_formula;
+};
+
+// Parses the whole batch into live programs, then drops them all, rounds times
+static Result run(Evaluator<char, double> &eval, const std::vector<std::string> &batch, bool use_arena, int rounds)
+{
+    core::Arena arena(64 * 1024);
+    std::vector<core::Program<double>> programs;
+    programs.reserve(batch.size());
+    auto begin = std::chrono::steady_clock::now();
+    const auto stats = core::count_allocations(
+        [&]()
+        {
+            for (int r = 0; r < rounds; ++r)
+            {
+                for (const auto &f : batch)
+                    programs.push_back(use_arena ? eval.parse(f, arena) : eval.parse(f));
+                programs.clear();
+                arena.reset();
+            }
+        });
+    auto end = std::chrono::steady_clock::now();
+    const double parsed = double(batch.size()) * rounds;
+    return Result{std::chrono::duration<double, std::nano>(end - begin).count() / parsed,
+                  double(stats.allocations) / parsed};
+}
+
+int main(int argc, char **argv)
+{
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 20;
+    const Options plain = Options::WhitespaceSkip | Options::ConstantParser | Options::Parentheses |
+                          Options::Comma | Options::BuiltinOps | Options::BuiltinConstants | Options::BuiltinFuncs;
+    auto batch = formulas(10000);
+
+    std::printf("options,storage,ns_per_formula,allocations_per_formula\n");
+    const Options cases[] = {plain, Options::All};
+    const char *names[] = {"plain", "all"};
+    for (int i = 0; i < 2; ++i)
+    {
+        Evaluator<char, double> eval(cases[i]);
+        eval.add_variable("x", 0.5);
+        eval.add_variable("y", 2.0);
+        for (int arena = 0; arena < 2; ++arena)
+        {
+            auto result = run(eval, batch, arena != 0, rounds);
+            std::printf("%s,%s,%.1f,%.2f\n", names[i], arena ? "arena" : "heap", result.ns_per_formula,
+                        result.allocations_per_formula);
+        }
+    }
+    return 0;
+}
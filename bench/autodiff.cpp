@@ -0,0 +1,87 @@
+#include "../include/eval.hpp"
+#include "../include/eval_autodiff.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// n variables, each behind some transcendental work, the same shape as the calibration models
+static std::string model(int n)
+{
+    std::string expr;
+    for (int i = 0; i < n; ++i)
+    {
+        auto v = "v" + std::to_string(i), w = "v" + std::to_string((i + 1) % n);
+        if (i)
+            expr += " + ";
+        expr += "exp(-" + v + "*" + v + ") * sin(" + w + ") + sqrt(" + v + "*" + v + " + 1) * atan2(" + v + ", " + w +
+                " + 2)";
+    }
+    return expr;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+    std::printf("variables,finite_diff_ns,forward_ns,reverse_ns,speedup,finite_diff_max_error\n");
+    for (int n : {1, 4, 16, 64})
+    {
+        Evaluator<char, double> eval(Options::All);
+        std::vector<double *> vars;
+        for (int i = 0; i < n; ++i)
+        {
+            eval.add_variable("v" + std::to_string(i), 0.1 * i + 0.05);
+            vars.push_back(eval.find_variable("v" + std::to_string(i)));
+        }
+        auto program = eval.parse(model(n));
+        core::Workspace<double> ws(program);
+        core::AutoDiff<double> ad(program);
+        std::vector<std::size_t> slots;
+        for (auto var : vars)
+            slots.push_back(program.slot_of(var));
+
+        // Forward differences: one base value plus one per variable
+        std::vector<double> fd(n), grad;
+        volatile double sink = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it)
+        {
+            const double base = program.value(ws);
+            for (int i = 0; i < n; ++i)
+            {
+                const double old = *vars[i], h = 1e-7 * (std::fabs(old) + 1);
+                *vars[i] = old + h;
+                fd[i] = (program.value(ws) - base) / h;
+                *vars[i] = old;
+            }
+            sink = sink + fd[0];
+        }
+        auto end = std::chrono::steady_clock::now();
+        const double fd_ns = std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+
+        // Forward mode: one dual pass per variable
+        begin = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it)
+            for (int i = 0; i < n; ++i)
+                sink = sink + ad.derivative(slots[i]).derivative;
+        end = std::chrono::steady_clock::now();
+        const double forward_ns = std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+
+        begin = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it)
+            sink = sink + ad.gradient(grad);
+        end = std::chrono::steady_clock::now();
+        const double reverse_ns = std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+
+        double error = 0;
+        for (int i = 0; i < n; ++i)
+            error = std::fmax(error, std::fabs(fd[i] - grad[slots[i]]));
+        std::printf("%d,%.1f,%.1f,%.1f,%.2f,%.3g\n", n, fd_ns, forward_ns, reverse_ns, fd_ns / reverse_ns, error);
+    }
+    return 0;
+}
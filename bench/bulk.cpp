@@ -0,0 +1,59 @@
+#include "../include/eval_bulk.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Compiling a formula file: a serial parse() loop against load_formulas on 1..N threads.
+// argv[1] is the number of formulas.
+
+static std::string formula(int i)
+{
+    auto v = "v" + std::to_string(i % 64), w = "v" + std::to_string((i * 7 + 3) % 64);
+    return "f" + std::to_string(i) + " = " + v + " * " + std::to_string(i % 9 + 1) + " + sin(" + w + ")^2 - sqrt(abs(" +
+           v + " - " + w + ")) / (" + w + " + " + std::to_string(i % 5 + 2) + ")";
+}
+
+int main(int argc, char **argv)
+{
+    const int count = argc > 1 && std::atoi(argv[1]) > 0 ? std::atoi(argv[1]) : 50000;
+    Evaluator<char, double> eval(Options::All);
+    for (int i = 0; i < 64; ++i)
+        eval.add_variable("v" + std::to_string(i), 0.5 + i);
+    std::string text;
+    for (int i = 0; i < count; ++i)
+        text += formula(i) + '\n';
+
+    std::printf("mode,threads,formulas,ms,formulas_per_s,speedup\n");
+    double serial_ms;
+    {
+        std::istringstream in(text);
+        std::string line;
+        std::size_t parsed = 0;
+        auto begin = std::chrono::steady_clock::now();
+        while (std::getline(in, line))
+            parsed += eval.parse(line.substr(line.find('=') + 1)).code.size() ? 1 : 0;
+        serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("serial,1,%zu,%.2f,%.0f,1.00\n", parsed, serial_ms, parsed / serial_ms * 1e3);
+    }
+
+    const std::size_t hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    for (std::size_t threads = 1; threads <= hardware; threads *= 2)
+    {
+        core::ThreadPool pool(threads);
+        std::istringstream in(text);
+        auto begin = std::chrono::steady_clock::now();
+        auto set = load_formulas(eval, in, pool);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("bulk,%zu,%zu,%.2f,%.0f,%.2f\n", threads, set.formulas.size(), ms, set.formulas.size() / ms * 1e3,
+                    serial_ms / ms);
+        if (threads < hardware && threads * 2 > hardware)
+            threads = hardware / 2;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Re-registers the arithmetic operators and a few functions as plain lambdas, which
+// carry OpCode::None and therefore always go through std::function
+static void add_generic_operators(Evaluator<char, double> &eval)
+{
+    eval.add_infix("+", [](core::ParamViewer<double> a) { return a[0] + a[1]; }, 10);
+    eval.add_infix("-", [](core::ParamViewer<double> a) { return a[0] - a[1]; }, 10);
+    eval.add_infix("*", [](core::ParamViewer<double> a) { return a[0] * a[1]; }, 20);
+    eval.add_infix("/", [](core::ParamViewer<double> a) { return a[0] / a[1]; }, 20);
+    eval.add_infix(
+        "^", [](core::ParamViewer<double> a) { return std::pow(a[0], a[1]); }, 30, core::Associativity::Right);
+    eval.add_prefix("-", [](core::ParamViewer<double> a) { return -a[0]; }, 40);
+    eval.add_function("sin", [](core::ParamViewer<double> a) { return std::sin(a[0]); });
+    eval.add_function("cos", [](core::ParamViewer<double> a) { return std::cos(a[0]); });
+    eval.add_function("exp", [](core::ParamViewer<double> a) { return std::exp(a[0]); });
+    eval.add_function("sqrt", [](core::ParamViewer<double> a) { return std::sqrt(a[0]); });
+}
+
+// Nanoseconds per evaluation of expr over a sweep of x
+static double time_expression(bool native, const char *expr, int iterations)
+{
+    Evaluator<char, double> eval(Options::All);
+    if (!native)
+        add_generic_operators(eval);
+    eval.add_variable("y", 1.25);
+    eval.add_variable("x", 0.0);
+    auto &x = eval.get_variable("x");
+    auto program = eval.parse(expr);
+    core::Workspace<double> ws(program);
+
+    volatile double sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        x = 0.5 + i * 1e-6;
+        sink = sink + program.value(ws);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const char *cases[] = {
+        "x+y",
+        "x*y-x/y",
+        "-x*(y+x)-(x-y)*(x+y)",
+        "x*x*x+y*x*x-x*y+y",
+        "sin(x)*cos(y)+sqrt(x*x+y*y)",
+        "exp(-x*x/2)/sqrt(2*3.14159)",
+        "x^y+y^x",
+    };
+
+    std::printf("expression,function_ns,native_ns,speedup\n");
+    for (auto expr : cases)
+    {
+        double generic = time_expression(false, expr, iterations);
+        double native = time_expression(true, expr, iterations);
+        std::printf("\"%s\",%.2f,%.2f,%.2f\n", expr, generic, native, generic / native);
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Nanoseconds per evaluate() call cycling through a fixed set of formula strings
+static double time_evaluate(std::size_t capacity, const std::vector<std::string> &formulas, int iterations,
+                            CacheStats &stats)
+{
+    Evaluator<char, double> eval;
+    eval.add_variable("x", 0.5);
+    eval.add_variable("y", 1.25);
+    eval.set_cache_capacity(capacity);
+
+    volatile double sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        sink = sink + eval.evaluate(formulas[i % formulas.size()]);
+    auto end = std::chrono::steady_clock::now();
+    stats = eval.cache_stats();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::printf("formulas,capacity,ns_per_call,hits,misses\n");
+    for (std::size_t count : {16, 256, 512})
+    {
+        std::vector<std::string> formulas;
+        for (std::size_t i = 0; i < count; ++i)
+            formulas.push_back("sin(x)*" + std::to_string(i) + "+sqrt(y^2+x^2)/(1+x*" + std::to_string(i % 7) + ")");
+        for (std::size_t capacity : {std::size_t(0), std::size_t(256)})
+        {
+            CacheStats stats;
+            double ns = time_evaluate(capacity, formulas, iterations, stats);
+            std::printf("%zu,%zu,%.2f,%zu,%zu\n", count, capacity, ns, stats.hits, stats.misses);
+        }
+    }
+    return 0;
+}
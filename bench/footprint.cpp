@@ -0,0 +1,73 @@
+#define EVAL_COUNT_ALLOCATIONS
+#include "../include/eval.hpp"
+#include "../include/eval_instrument.hpp"
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Allocations per parse and evaluation, and the resident size of both expression forms and
+// of the symbol trie under each child map. Usage: bench_footprint [terms of the largest formula]
+
+static std::string formula(int terms)
+{
+    std::string expr = "x";
+    for (int i = 1; i < terms; ++i)
+        expr += (i % 2 ? " + sin(x * " : " - hypot(y, ") + std::to_string(i) + ")";
+    return expr;
+}
+
+template <template <typename, typename> class MapType>
+static void trie(const char *map)
+{
+    Evaluator<char, double, MapType> eval(Options::All);
+    for (int i = 0; i < 1000; ++i)
+        eval.add_variable("sensor_" + std::to_string(i % 10) + "_" + std::to_string(i), 0.0);
+    auto f = core::footprint(eval.symbols());
+    std::printf("trie,%s,1000,%zu,%zu,%zu\n", map, f.nodes, f.blocks, f.bytes);
+}
+
+int main(int argc, char **argv)
+{
+    const int largest = argc > 1 ? std::atoi(argv[1]) : 1000;
+    Evaluator<char, double> eval(Options::All);
+    eval.add_variable("x", 0.5);
+    eval.add_variable("y", 1.5);
+
+    // blocks is the allocation count for parse/value/evaluate rows and the resident blocks otherwise
+    std::printf("what,form,terms,nodes,blocks,bytes\n");
+    for (int terms = 1; terms <= largest; terms *= 10)
+    {
+        const auto expr = formula(terms);
+        core::Program<double> program;
+        auto parse = core::count_allocations([&]() { program = eval.parse(expr); });
+        std::printf("parse,program,%d,%zu,%zu,%zu\n", terms, program.code.size(), parse.allocations, parse.bytes);
+
+        core::Workspace<double> ws(program);
+        volatile double sink = 0;
+        auto value = core::count_allocations([&]() { sink = sink + program.value(ws); });
+        std::printf("value,program,%d,%zu,%zu,%zu\n", terms, program.code.size(), value.allocations, value.bytes);
+        auto resident = core::footprint(program);
+        std::printf("resident,program,%d,%zu,%zu,%zu\n", terms, resident.nodes, resident.blocks, resident.bytes);
+
+        core::Expression<double, std::shared_ptr> legacy;
+        parse = core::count_allocations([&]() { legacy = eval.parse<std::shared_ptr>(expr); });
+        std::printf("parse,expression,%d,%zu,%zu,%zu\n", terms, legacy.index.size(), parse.allocations, parse.bytes);
+        value = core::count_allocations([&]() { sink = sink + legacy.value(); });
+        std::printf("value,expression,%d,%zu,%zu,%zu\n", terms, legacy.index.size(), value.allocations, value.bytes);
+        resident = core::footprint(legacy);
+        std::printf("resident,expression,%d,%zu,%zu,%zu\n", terms, resident.nodes, resident.blocks, resident.bytes);
+
+        eval.clear_cache();
+        auto miss = core::count_allocations([&]() { sink = sink + eval.evaluate(expr); });
+        auto hit = core::count_allocations([&]() { sink = sink + eval.evaluate(expr); });
+        std::printf("evaluate_miss,cache,%d,%zu,%zu,%zu\n", terms, program.code.size(), miss.allocations, miss.bytes);
+        std::printf("evaluate_hit,cache,%d,%zu,%zu,%zu\n", terms, program.code.size(), hit.allocations, hit.bytes);
+    }
+    trie<core::StdMap>("std_map");
+    trie<core::FlatMap>("flat_map");
+    trie<core::AsciiMap>("ascii_map");
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// A feed tick: every instrument field gets a new value, then one formula reads a few of them
+int main(int argc, char **argv)
+{
+    const int ticks = argc > 1 ? std::atoi(argv[1]) : 20000;
+    Evaluator<char, double> eval(Options::All);
+    std::vector<std::string> names;
+    for (int i = 0; i < 200; ++i)
+    {
+        names.push_back("instrument_" + std::to_string(i) + "_last_price");
+        eval.add_variable(names.back(), 100.0 + i);
+    }
+    std::vector<core::VariableHandle<double>> handles;
+    for (const auto &name : names)
+        handles.push_back(eval.bind(name));
+    auto program = eval.parse(names[3] + " * 2 - " + names[150] + " / " + names[199]);
+    core::Workspace<double> ws(program);
+
+    volatile double sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; ++t)
+    {
+        for (std::size_t i = 0; i < names.size(); ++i)
+            eval.set_variable(names[i], t + i * 0.5);
+        sink = sink + program.value(ws);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; ++t)
+    {
+        for (std::size_t i = 0; i < handles.size(); ++i)
+            eval.set(handles[i], t + i * 0.5);
+        sink = sink + program.value(ws);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const double updates = double(ticks) * names.size();
+    const double by_name = std::chrono::duration<double, std::nano>(middle - begin).count() / updates;
+    const double by_handle = std::chrono::duration<double, std::nano>(end - middle).count() / updates;
+    std::printf("variables,by_name_ns,by_handle_ns,speedup\n");
+    std::printf("%zu,%.2f,%.2f,%.2f\n", names.size(), by_name, by_handle, by_name / by_handle);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Regression suite for the hot paths: parsing, both evaluators, evaluate(), set_variable and
+// the symbol trie, over every key and data type and expression sizes from 5 to 100k tokens.
+// Usage: bench_hot_paths [tokens per measurement, 0 keeps the default] [csv|json]
+
+// Parsing without folding or CSE, so the time is the parser itself
+static const Options parse_only = Options::WhitespaceSkip | Options::ConstantParser | Options::Parentheses |
+                                  Options::Comma | Options::BuiltinOps | Options::BuiltinConstants |
+                                  Options::BuiltinFuncs;
+
+static const std::size_t sizes[] = {5, 50, 500, 5000, 100000};
+static const int variables = 16;
+
+static long long budget = 1000000;
+static bool json = false;
+static bool first_row = true;
+
+template <typename T> static const char *type_name();
+template <> const char *type_name<char>() { return "char"; }
+template <> const char *type_name<wchar_t>() { return "wchar_t"; }
+template <> const char *type_name<float>() { return "float"; }
+template <> const char *type_name<double>() { return "double"; }
+template <> const char *type_name<long double>() { return "long double"; }
+template <> const char *type_name<int>() { return "int"; }
+
+template <typename CharType>
+static std::basic_string<CharType> widen(const std::string &text)
+{
+    return std::basic_string<CharType>(text.begin(), text.end());
+}
+
+// v0 + v1 * 2 - v2 * 3 + ...: four tokens per term, integer constants so int stays in range
+static std::string expression(std::size_t tokens)
+{
+    std::string expr = "v0";
+    for (std::size_t i = 1; 1 + 4 * i <= tokens; ++i)
+        expr += (i % 2 ? " + v" : " - v") + std::to_string(i % variables) + " * " + std::to_string(i % 7 + 1);
+    return expr;
+}
+
+template <typename KeyType, typename DataType>
+static void report(const char *path, std::size_t tokens, long long iterations,
+                   std::chrono::steady_clock::duration elapsed)
+{
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    const double per_token = tokens ? ns / tokens : ns;
+    if (json)
+        std::printf("%s\n  {\"path\": \"%s\", \"key\": \"%s\", \"data\": \"%s\", \"tokens\": %zu, \"iterations\": %lld, "
+                    "\"ns_per_op\": %.2f, \"ns_per_token\": %.3f}",
+                    first_row ? "[" : ",", path, type_name<KeyType>(), type_name<DataType>(), tokens, iterations, ns,
+                    per_token);
+    else
+        std::printf("%s,%s,%s,%zu,%lld,%.2f,%.3f\n", path, type_name<KeyType>(), type_name<DataType>(), tokens,
+                    iterations, ns, per_token);
+    first_row = false;
+}
+
+template <typename Fn>
+static std::chrono::steady_clock::duration measure(long long iterations, Fn fn)
+{
+    fn(); // warm up caches and lazily built state
+    auto begin = std::chrono::steady_clock::now();
+    for (long long i = 0; i < iterations; ++i)
+        fn();
+    return std::chrono::steady_clock::now() - begin;
+}
+
+template <typename KeyType, typename DataType>
+static void run()
+{
+    volatile double sink = 0;
+    Evaluator<KeyType, DataType> parser(parse_only), eval(Options::All);
+    std::vector<std::basic_string<KeyType>> names;
+    for (int i = 0; i < variables; ++i)
+    {
+        names.push_back(widen<KeyType>("v" + std::to_string(i)));
+        parser.add_variable(names.back(), DataType(i % 5 + 1));
+        eval.add_variable(names.back(), DataType(i % 5 + 1));
+    }
+
+    for (auto tokens : sizes)
+    {
+        const auto expr = widen<KeyType>(expression(tokens));
+        const long long iterations = budget / static_cast<long long>(tokens) + 1;
+
+        report<KeyType, DataType>("parse", tokens, iterations,
+                                  measure(iterations, [&]() { sink = sink + parser.parse(expr).code.size(); }));
+
+        auto program = eval.parse(expr);
+        core::Workspace<DataType> ws(program);
+        report<KeyType, DataType>("program_value", tokens, iterations,
+                                  measure(iterations, [&]() { sink = sink + double(program.value(ws)); }));
+
+        auto legacy = eval.template parse<std::shared_ptr>(expr);
+        report<KeyType, DataType>("expression_value", tokens, iterations,
+                                  measure(iterations, [&]() { sink = sink + double(legacy.value()); }));
+
+        report<KeyType, DataType>("evaluate", tokens, iterations,
+                                  measure(iterations, [&]() { sink = sink + double(eval.evaluate(expr)); }));
+    }
+
+    // Per-call paths, independent of the expression size
+    const long long calls = budget;
+    int next = 0;
+    report<KeyType, DataType>("set_variable", 0, calls,
+                              measure(calls,
+                                      [&]()
+                                      {
+                                          eval.set_variable(names[next % variables], DataType(next & 7));
+                                          ++next;
+                                      }));
+
+    // A trie of 1024 names with shared prefixes, like the symbol table of a large model
+    std::vector<std::basic_string<KeyType>> keys;
+    for (int i = 0; i < 1024; ++i)
+        keys.push_back(widen<KeyType>("signal_" + std::to_string(i % 32) + "_" + std::to_string(i)));
+    const long long rounds = budget / 1024 + 1;
+    report<KeyType, DataType>("node_insert", 0, rounds * 1024,
+                              measure(rounds,
+                                      [&]()
+                                      {
+                                          core::Node<core::StdMap, KeyType, DataType> root;
+                                          for (const auto &key : keys)
+                                              root.insert(key)->template set_data<0>(std::make_shared<DataType>(1));
+                                          sink = sink + root.get_child().size();
+                                      }));
+    core::Node<core::StdMap, KeyType, DataType> root;
+    for (const auto &key : keys)
+        root.insert(key)->template set_data<0>(std::make_shared<DataType>(1));
+    report<KeyType, DataType>("node_search", 0, rounds * 1024,
+                              measure(rounds,
+                                      [&]()
+                                      {
+                                          for (const auto &key : keys)
+                                              sink = sink + double(*root.search(key)->template get_data<0>());
+                                      }));
+}
+
+template <typename KeyType>
+static void run_key()
+{
+    run<KeyType, float>();
+    run<KeyType, double>();
+    run<KeyType, long double>();
+    run<KeyType, int>();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::atoll(argv[1]) > 0)
+        budget = std::atoll(argv[1]);
+    json = argc > 2 && !std::strcmp(argv[2], "json");
+    if (!json)
+        std::printf("path,key,data,tokens,iterations,ns_per_op,ns_per_token\n");
+    run_key<char>();
+    run_key<wchar_t>();
+    if (json)
+        std::printf("\n]\n");
+    return 0;
+}
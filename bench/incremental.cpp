@@ -0,0 +1,72 @@
+#include "../include/eval.hpp"
+#include "../include/eval_incremental.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// 30 variables in ten groups of three, each group behind some transcendental work
+static std::string model()
+{
+    std::string expr;
+    for (int g = 0; g < 10; ++g)
+    {
+        auto a = "v" + std::to_string(g * 3), b = "v" + std::to_string(g * 3 + 1), c = "v" + std::to_string(g * 3 + 2);
+        if (g)
+            expr += " + ";
+        expr += "(exp(-" + a + "*" + a + ") * sin(" + b + ") + sqrt(" + c + "*" + c + " + 1) * atan2(" + a + ", " +
+                c + " + 2))";
+    }
+    return expr;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    Evaluator<char, double> eval(Options::All);
+    std::vector<core::VariableHandle<double>> vars;
+    for (int i = 0; i < 30; ++i)
+    {
+        eval.add_variable("v" + std::to_string(i), 0.1 * i);
+        vars.push_back(eval.bind("v" + std::to_string(i)));
+    }
+    auto program = eval.parse(model());
+    core::Workspace<double> ws(program);
+    core::IncrementalProgram<double> incremental(program);
+
+    std::printf("changed,full_ns,incremental_ns,speedup,operators_recomputed\n");
+    for (int changed = 1; changed <= 3; ++changed)
+    {
+        std::mt19937 rng(changed);
+        volatile double sink = 0;
+        std::size_t recomputed = 0;
+        double full_ns = 0, incremental_ns = 0;
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                for (int j = 0; j < changed; ++j)
+                    eval.set(vars[rng() % vars.size()], (rng() % 1000) * 0.001);
+                if (pass)
+                {
+                    sink = sink + incremental.value();
+                    recomputed += incremental.recomputed();
+                }
+                else
+                    sink = sink + program.value(ws);
+            }
+            auto end = std::chrono::steady_clock::now();
+            (pass ? incremental_ns : full_ns) =
+                std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+        }
+        std::printf("%d,%.2f,%.2f,%.2f,%.2f\n", changed, full_ns, incremental_ns, full_ns / incremental_ns,
+                    double(recomputed) / iterations);
+    }
+    return 0;
+}
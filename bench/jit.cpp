@@ -0,0 +1,55 @@
+#include "../include/eval.hpp"
+#include "../include/eval_jit.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Nanoseconds per evaluation of run() over a sweep of x
+template <typename Run>
+static double time_loop(double &x, int iterations, Run run)
+{
+    volatile double sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        x = 0.5 + i * 1e-6;
+        sink = sink + run();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const char *cases[] = {
+        "x+y",
+        "x*y-x/y",
+        "-x*(y+x)-(x-y)*(x+y)",
+        "3*x^4-2*x^3+x^2-7*x+5",
+        "sin(x)*cos(y)+sqrt(x*x+y*y)",
+        "exp(-x*x/2)/sqrt(2*pi)",
+        "abs(x-y)+sqrt(abs(x*y))-x/(1+x*x)",
+    };
+
+    std::printf("expression,native,interpreter_ns,jit_ns,speedup\n");
+    for (auto expr : cases)
+    {
+        Evaluator<char, double> eval;
+        eval.add_variable("y", 1.25);
+        eval.add_variable("x", 0.0);
+        auto &x = eval.get_variable("x");
+        auto program = eval.parse(expr);
+        core::JitProgram<double> jit(eval.parse(expr));
+        core::Workspace<double> ws(program);
+
+        double interpreted = time_loop(x, iterations, [&]() { return program.value(ws); });
+        double native = time_loop(x, iterations, [&]() { return jit.value(ws); });
+        std::printf("\"%s\",%d,%.2f,%.2f,%.2f\n", expr, jit.native() ? 1 : 0, interpreted, native,
+                    interpreted / native);
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// The constant parser as it was before core::parse_number: scan digits and one point,
+// then read the copy through a stream
+template <typename CharType>
+static const CharType *stream_number(const CharType *first, const CharType *last, double &value)
+{
+    auto p = first;
+    bool dot = false, digit = false;
+    for (; p < last; ++p)
+        if (*p >= CharType('0') && *p <= CharType('9'))
+            digit = true;
+        else if (*p == CharType('.') && !dot)
+            dot = true;
+        else
+            break;
+    if (!digit)
+        return first;
+    std::basic_stringstream<CharType> ss(std::basic_string<CharType>(first, p));
+    ss >> value;
+    return p;
+}
+
+// Literals typical of generated code: short integers, fixed-point, full precision and scientific
+static const char *kinds[] = {"integer", "fixed", "full", "scientific"};
+
+static std::vector<std::string> literals(int kind, std::size_t count)
+{
+    std::mt19937_64 rng(7);
+    std::vector<std::string> out;
+    char buffer[64];
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double unit = double(rng() % 1000000007) / 1000000007.0;
+        switch (kind)
+        {
+        case 0:
+            std::snprintf(buffer, sizeof(buffer), "%u", static_cast<unsigned>(rng() % 1000));
+            break;
+        case 1:
+            std::snprintf(buffer, sizeof(buffer), "%.4f", unit * 1000);
+            break;
+        case 2:
+            std::snprintf(buffer, sizeof(buffer), "%.17g", unit);
+            break;
+        default:
+            std::snprintf(buffer, sizeof(buffer), "%.6e", unit * std::pow(10.0, int(rng() % 40) - 20));
+            break;
+        }
+        out.push_back(buffer);
+    }
+    return out;
+}
+
+template <typename CharType, typename Parse>
+static double time_literals(const std::vector<std::string> &texts, int iterations, Parse parse)
+{
+    std::vector<std::basic_string<CharType>> inputs;
+    for (const auto &text : texts)
+        inputs.push_back(std::basic_string<CharType>(text.begin(), text.end()));
+    volatile double sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        for (const auto &input : inputs)
+        {
+            double value = 0;
+            parse(input.data(), input.data() + input.size(), value);
+            sink = sink + value;
+        }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / (double(inputs.size()) * iterations);
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    std::printf("kind,key,stream_ns,parse_number_ns,speedup\n");
+    for (int kind = 0; kind < 4; ++kind)
+    {
+        auto texts = literals(kind, 1000);
+        double stream = time_literals<char>(texts, iterations, stream_number<char>);
+        double fast = time_literals<char>(texts, iterations, core::parse_number<char, double>);
+        std::printf("%s,char,%.2f,%.2f,%.2f\n", kinds[kind], stream, fast, stream / fast);
+        stream = time_literals<wchar_t>(texts, iterations, stream_number<wchar_t>);
+        fast = time_literals<wchar_t>(texts, iterations, core::parse_number<wchar_t, double>);
+        std::printf("%s,wchar_t,%.2f,%.2f,%.2f\n", kinds[kind], stream, fast, stream / fast);
+    }
+    return 0;
+}
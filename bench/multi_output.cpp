@@ -0,0 +1,88 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// 40 outputs of one pricing model (price, delta, vega, ... and bumped variants), evaluated as
+// separate programs against one multi-output program sharing d1, d2 and the discount factor
+
+static std::vector<std::string> outputs()
+{
+    const std::string d1 = "(ln(s/k) + (r + v^2/2)*t) / (v*sqrt(t))";
+    const std::string d2 = "(" + d1 + " - v*sqrt(t))";
+    const std::string n1 = "(1+erf(" + d1 + "/sqrt(2)))/2", n2 = "(1+erf(" + d2 + "/sqrt(2)))/2";
+    const std::string pdf = "exp(-(" + d1 + ")^2/2)/sqrt(2*pi)", df = "exp(-r*t)";
+    const std::string base[] = {"s*" + n1 + " - k*" + df + "*" + n2,  // price
+                                n1,                                    // delta
+                                "s*" + pdf + "*sqrt(t)",               // vega
+                                pdf + "/(s*v*sqrt(t))",                // gamma
+                                "k*t*" + df + "*" + n2,                // rho
+                                "-s*" + pdf + "*v/(2*sqrt(t)) - r*k*" + df + "*" + n2, // theta
+                                "-" + pdf + "*" + d2 + "/v",           // vanna
+                                "s*" + pdf + "*sqrt(t)*" + d1 + "*" + d2 + "/v"}; // volga
+    std::vector<std::string> result;
+    for (int scale = 1; scale <= 5; ++scale)
+        for (const auto &expr : base)
+            result.push_back(std::to_string(scale) + " * (" + expr + ")");
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    const long long iterations = argc > 1 && std::atoll(argv[1]) > 0 ? std::atoll(argv[1]) : 20000;
+    Evaluator<char, double> eval(Options::All);
+    eval.add_variable("s", 100);
+    eval.add_variable("k", 95);
+    eval.add_variable("t", 0.5);
+    eval.add_variable("v", 0.2);
+    eval.add_variable("r", 0.01);
+    double *spot = eval.find_variable("s");
+    const auto exprs = outputs();
+
+    std::vector<core::Program<double>> separate;
+    std::size_t separate_ops = 0;
+    for (const auto &expr : exprs)
+    {
+        separate.push_back(eval.parse(expr));
+        for (const auto &ins : separate.back().code)
+            separate_ops += ins.type == core::TokenType::Operator;
+    }
+    const auto multi = eval.parse_outputs(exprs);
+    std::size_t multi_ops = 0;
+    for (const auto &ins : multi.code)
+        multi_ops += ins.type == core::TokenType::Operator;
+
+    std::vector<double> out(exprs.size());
+    volatile double sink = 0;
+    core::Workspace<double> ws;
+    auto begin = std::chrono::steady_clock::now();
+    for (long long it = 0; it < iterations; ++it)
+    {
+        *spot = 90 + it % 20;
+        for (std::size_t i = 0; i < separate.size(); ++i)
+            out[i] = separate[i].value(ws);
+        sink = sink + out[0];
+    }
+    const double separate_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / iterations;
+
+    begin = std::chrono::steady_clock::now();
+    for (long long it = 0; it < iterations; ++it)
+    {
+        *spot = 90 + it % 20;
+        multi.values(ws, out.data());
+        sink = sink + out[0];
+    }
+    const double multi_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / iterations;
+
+    std::printf("outputs,separate_operators,shared_operators,separate_ns,shared_ns,speedup\n");
+    std::printf("%zu,%zu,%zu,%.1f,%.1f,%.2f\n", exprs.size(), separate_ops, multi_ops, separate_ns, multi_ns,
+                separate_ns / multi_ns);
+    return 0;
+}
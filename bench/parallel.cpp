@@ -0,0 +1,64 @@
+#include "../include/eval.hpp"
+#include "../include/eval_parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+template <typename Run>
+static double seconds(Run run)
+{
+    auto begin = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1u << 22;
+    const std::size_t jobs = 20000;
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    Evaluator<char, double> eval;
+    eval.add_variable("x", 0.0);
+    eval.add_variable("y", 1.25);
+    auto program = eval.parse("sin(x)*cos(y)+sqrt(x*x+y*y)-x/(1+y*y)");
+    std::vector<double> xs(rows), out(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+        xs[i] = i * 1e-6;
+    std::vector<core::Binding<double>> inputs{eval.bind_column("x", xs.data(), rows)};
+
+    std::vector<core::Program<double>> programs;
+    std::vector<core::Frame<double>> frames;
+    for (std::size_t i = 0; i < jobs; ++i)
+    {
+        programs.push_back(eval.parse("x^2*" + std::to_string(i % 97) + "+sin(y*x)-" + std::to_string(i % 13)));
+        frames.emplace_back(programs.back());
+        frames.back()[0] = i * 1e-3;
+    }
+    std::vector<double> results(jobs);
+
+    std::printf("mode,threads,seconds,speedup\n");
+    double batch_single = 0, values_single = 0;
+    for (unsigned threads = 1; threads <= hardware; threads *= 2)
+    {
+        core::ThreadPool pool(threads);
+        double batch = seconds([&]() { core::parallel_batch(pool, program, inputs, out.data(), rows); });
+        double values = seconds([&]() { core::parallel_values(pool, programs, frames, results.data()); });
+        if (threads == 1)
+        {
+            batch_single = batch;
+            values_single = values;
+        }
+        std::printf("batch,%u,%.4f,%.2f\n", threads, batch, batch_single / batch);
+        std::printf("values,%u,%.4f,%.2f\n", threads, values, values_single / values);
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "../include/eval.hpp"
+#include "../include/eval_profile.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Cost of the profiling policies: the default must match plain value(ws), the Profiler adds
+// two clock reads and a counter update per operator
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    Evaluator<char, double> eval(Options::All);
+    eval.add_variable("x", 0.5);
+    eval.add_variable("y", 1.5);
+    const char *formulas[] = {"x+y", "x*y-x/y+sin(x)", "sqrt(x*x+y*y)*exp(-x)+atan2(y,x)-hypot(x,y)/(1+x)"};
+
+    std::printf("expression,operators,plain_ns,no_profile_ns,profiler_ns\n");
+    for (auto formula : formulas)
+    {
+        auto program = eval.parse(formula);
+        core::Workspace<double> ws(program);
+        core::NoProfile none;
+        core::Profiler profiler;
+        volatile double sink = 0;
+        double ns[3];
+        for (int mode = 0; mode < 3; ++mode)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+                sink = sink + (mode == 0   ? program.value(ws)
+                               : mode == 1 ? program.value(ws, none)
+                                           : program.value(ws, profiler));
+            auto end = std::chrono::steady_clock::now();
+            ns[mode] = std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+        }
+        std::size_t operators = 0;
+        for (const auto &ins : program.code)
+            operators += ins.type == core::TokenType::Operator;
+        std::printf("\"%s\",%zu,%.2f,%.2f,%.2f\n", formula, operators, ns[0], ns[1], ns[2]);
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Cold start of a formula library: parsing every formula again against loading a saved image
+// from a mapped file. argv[1] is the number of formulas.
+
+static std::string formula(int i)
+{
+    auto v = "v" + std::to_string(i % 64), w = "v" + std::to_string((i * 7 + 3) % 64);
+    return v + " * " + std::to_string(i % 9 + 1) + " + sin(" + w + ")^2 - sqrt(abs(" + v + " - " + w + ")) / (" +
+           w + " + " + std::to_string(i % 5 + 2) + ")";
+}
+
+template <typename Fn>
+static double seconds(Fn fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    const int count = argc > 1 && std::atoi(argv[1]) > 0 ? std::atoi(argv[1]) : 50000;
+    Evaluator<char, double> eval(Options::All);
+    for (int i = 0; i < 64; ++i)
+        eval.add_variable("v" + std::to_string(i), 0.5 + i);
+    std::vector<std::string> formulas;
+    for (int i = 0; i < count; ++i)
+        formulas.push_back(formula(i));
+
+    std::vector<core::Program<double>> parsed;
+    const double parse_s = seconds(
+        [&]()
+        {
+            parsed.reserve(formulas.size());
+            for (const auto &text : formulas)
+                parsed.push_back(eval.parse(text));
+        });
+
+    std::vector<char> image;
+    const double save_s = seconds([&]() { image = eval.save_image(parsed); });
+    const char *path = "serialize_bench.img";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(image.data(), static_cast<std::streamsize>(image.size()));
+    }
+
+    std::vector<core::Program<double>> loaded;
+    const double load_s = seconds(
+        [&]()
+        {
+            core::MappedFile file(path);
+            loaded = eval.load_image(file.data(), file.size());
+        });
+    std::remove(path);
+
+    double checksum = 0;
+    for (std::size_t i = 0; i < loaded.size(); ++i)
+        checksum += loaded[i].value() - parsed[i].value();
+
+    std::printf("formulas,image_bytes,parse_ms,save_ms,load_ms,speedup,checksum\n");
+    std::printf("%d,%zu,%.2f,%.2f,%.2f,%.1f,%g\n", count, image.size(), parse_s * 1e3, save_s * 1e3, load_s * 1e3,
+                parse_s / load_s, checksum);
+    return 0;
+}
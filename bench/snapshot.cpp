@@ -0,0 +1,134 @@
+#include "../include/eval.hpp"
+#include "../include/eval_snapshot.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Readers parsing while a writer changes symbols: one mutex around a shared evaluator against
+// core::Published snapshots, plus the cost of publishing a change on a large symbol table
+// (copying a StdMap trie against the path copy of a SharedMap trie). argv[1] is the number
+// of parses per reader.
+
+static const char *formula = "v1 * sin(v2) + sqrt(v3 * v3 + 1) - v4 / (v5 + 2)";
+
+template <typename Eval>
+static void fill(Eval &eval, int symbols)
+{
+    for (int i = 0; i < symbols; ++i)
+        eval.add_variable("v" + std::to_string(i), i);
+}
+
+template <typename Fn>
+static double elapsed_ms(Fn fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template <typename Read, typename Write>
+static double contended(int readers, long parses, Read read, Write write)
+{
+    std::atomic<bool> done{false};
+    std::thread writer(
+        [&]()
+        {
+            for (int i = 0; !done; ++i)
+            {
+                write(i);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    const double ms = elapsed_ms(
+        [&]()
+        {
+            std::vector<std::thread> threads;
+            for (int r = 0; r < readers; ++r)
+                threads.emplace_back(
+                    [&]()
+                    {
+                        for (long i = 0; i < parses; ++i)
+                            read();
+                    });
+            for (auto &t : threads)
+                t.join();
+        });
+    done = true;
+    writer.join();
+    return ms;
+}
+
+int main(int argc, char **argv)
+{
+    const long parses = argc > 1 && std::atol(argv[1]) > 0 ? std::atol(argv[1]) : 20000;
+    const int readers = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+
+    std::printf("case,symbols,readers,ms,ns_per_op\n");
+    {
+        Evaluator<char, double> locked;
+        fill(locked, 64);
+        std::mutex mutex;
+        const double ms = contended(
+            readers, parses,
+            [&]()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                locked.parse(formula);
+            },
+            [&](int i)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                locked.add_variable("w" + std::to_string(i % 16), i);
+            });
+        std::printf("mutex_parse,64,%d,%.2f,%.1f\n", readers, ms, ms * 1e6 / (parses * readers));
+    }
+    {
+        Evaluator<char, double, core::SharedMap> base;
+        fill(base, 64);
+        core::Published<Evaluator<char, double, core::SharedMap>> published(std::move(base));
+        const double ms = contended(
+            readers, parses, [&]() { published.snapshot()->parse(formula); },
+            [&](int i)
+            {
+                published.update([i](Evaluator<char, double, core::SharedMap> &eval)
+                                 { eval.add_variable("w" + std::to_string(i % 16), i); });
+            });
+        std::printf("snapshot_parse,64,%d,%.2f,%.1f\n", readers, ms, ms * 1e6 / (parses * readers));
+    }
+
+    const int updates = 200;
+    for (int symbols : {1000, 10000})
+    {
+        Evaluator<char, double> std_base;
+        fill(std_base, symbols);
+        core::Published<Evaluator<char, double>> std_published(std::move(std_base));
+        const double std_ms = elapsed_ms(
+            [&]()
+            {
+                for (int i = 0; i < updates; ++i)
+                    std_published.update([i](Evaluator<char, double> &eval) { eval.add_variable("w", i); });
+            });
+        std::printf("publish_stdmap,%d,0,%.2f,%.1f\n", symbols, std_ms, std_ms * 1e6 / updates);
+
+        Evaluator<char, double, core::SharedMap> shared_base;
+        fill(shared_base, symbols);
+        core::Published<Evaluator<char, double, core::SharedMap>> shared_published(std::move(shared_base));
+        const double shared_ms = elapsed_ms(
+            [&]()
+            {
+                for (int i = 0; i < updates; ++i)
+                    shared_published.update([i](Evaluator<char, double, core::SharedMap> &eval)
+                                            { eval.add_variable("w", i); });
+            });
+        std::printf("publish_sharedmap,%d,0,%.2f,%.1f\n", symbols, shared_ms, shared_ms * 1e6 / updates);
+    }
+    return 0;
+}
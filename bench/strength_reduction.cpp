@@ -0,0 +1,59 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Nanoseconds per evaluation of expr over a sweep of x
+static double time_expression(Options opt, const char *expr, int iterations)
+{
+    Evaluator<char, double> eval(opt);
+    for (auto name : {"a", "b", "c", "d"})
+        eval.add_variable(name, 1.25);
+    eval.add_variable("x", 0.0);
+    auto &x = eval.get_variable("x");
+    auto program = eval.parse(expr);
+    core::Workspace<double> ws(program);
+
+    volatile double sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        x = 0.5 + i * 1e-6;
+        sink = sink + program.value(ws);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    struct Case
+    {
+        const char *rewrite;
+        const char *expr;
+        Options after;
+    } cases[] = {
+        {"integer_power", "x^2", Options::All | Options::StrengthReduction},
+        {"integer_power", "x^3", Options::All | Options::StrengthReduction},
+        {"integer_power", "x^4", Options::All | Options::StrengthReduction},
+        {"integer_power", "x^5", Options::All | Options::StrengthReduction},
+        {"integer_power", "(x+1)^8", Options::All | Options::StrengthReduction},
+        {"reciprocal_division", "x/3", Options::All | Options::StrengthReduction | Options::FastMath},
+        {"reciprocal_division", "(x+a)/7+(x-b)/9", Options::All | Options::StrengthReduction | Options::FastMath},
+        {"horner", "a*x^3+b*x^2+c*x+d", Options::All | Options::StrengthReduction},
+        {"horner", "3*x^5-2*x^4+x^3-7*x^2+5*x-1", Options::All | Options::StrengthReduction},
+    };
+
+    std::printf("rewrite,expression,before_ns,after_ns,speedup\n");
+    for (const auto &c : cases)
+    {
+        double before = time_expression(Options::All, c.expr, iterations);
+        double after = time_expression(c.after, c.expr, iterations);
+        std::printf("%s,\"%s\",%.2f,%.2f,%.2f\n", c.rewrite, c.expr, before, after, before / after);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "../include/eval.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Parsing without folding or CSE, so the time is dominated by walking the symbol trie
+static const Options parse_only = Options::WhitespaceSkip | Options::ConstantParser | Options::Parentheses |
+                                  Options::Comma | Options::BuiltinOps | Options::BuiltinConstants |
+                                  Options::BuiltinFuncs;
+
+template <typename CharType>
+static std::basic_string<CharType> widen(const std::string &text)
+{
+    return std::basic_string<CharType>(text.begin(), text.end());
+}
+
+// 200 variables sharing long prefixes, like the fields of a generated model
+static std::vector<std::string> variable_names()
+{
+    const char *groups[] = {"sensor_temperature_", "sensor_pressure_", "actuator_position_", "controller_gain_"};
+    std::vector<std::string> names;
+    for (auto group : groups)
+        for (int i = 0; i < 50; ++i)
+            names.push_back(group + std::to_string(i));
+    return names;
+}
+
+// Sums and products of variables and function calls, count terms long
+static std::string identifier_expression(const std::vector<std::string> &names, int count, int seed)
+{
+    const char *functions[] = {"sin", "cos", "sqrt", "exp", "atan2", "hypot"};
+    std::string expr;
+    for (int i = 0; i < count; ++i)
+    {
+        const std::string &a = names[(seed + i * 37) % names.size()];
+        const std::string &b = names[(seed + i * 53 + 11) % names.size()];
+        const char *f = functions[(seed + i) % 6];
+        if (i)
+            expr += i % 3 ? " + " : " * ";
+        expr += f;
+        expr += (f[0] == 'a' || f[0] == 'h') ? "(" + a + ", " + b + ")" : "(" + a + ") - " + b;
+    }
+    return expr;
+}
+
+struct Timing
+{
+    double parse_ns_per_char;
+    double lookup_ns_per_name;
+};
+
+// Full parses of the expressions, and bare trie lookups of every variable name
+template <typename CharType, template <typename, typename> class MapType>
+static Timing time_symbols(const std::vector<std::string> &names, const std::vector<std::string> &exprs,
+                           int iterations)
+{
+    Evaluator<CharType, double, MapType> eval(parse_only);
+    for (std::size_t i = 0; i < names.size(); ++i)
+        eval.add_variable(widen<CharType>(names[i]), 1.0 + i * 0.001);
+    std::vector<std::basic_string<CharType>> inputs;
+    std::size_t chars = 0;
+    for (const auto &expr : exprs)
+    {
+        inputs.push_back(widen<CharType>(expr));
+        chars += expr.size();
+    }
+
+    std::vector<std::basic_string<CharType>> keys;
+    for (const auto &name : names)
+        keys.push_back(widen<CharType>(name));
+
+    volatile std::size_t sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        for (const auto &input : inputs)
+            sink = sink + eval.parse(input).code.size();
+    auto end = std::chrono::steady_clock::now();
+    const int lookups = iterations * 10;
+    volatile double total = 0;
+    auto lookup_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i)
+        for (const auto &key : keys)
+            total = total + eval.get_variable(key);
+    auto lookup_end = std::chrono::steady_clock::now();
+
+    Timing timing;
+    timing.parse_ns_per_char =
+        std::chrono::duration<double, std::nano>(end - begin).count() / (double(chars) * iterations);
+    timing.lookup_ns_per_name =
+        std::chrono::duration<double, std::nano>(lookup_end - lookup_begin).count() / (double(keys.size()) * lookups);
+    return timing;
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    auto names = variable_names();
+    std::vector<std::string> exprs;
+    for (int seed = 0; seed < 16; ++seed)
+        exprs.push_back(identifier_expression(names, 24, seed));
+
+    std::printf("key,map,parse_ns_per_char,parse_mchars_per_s,lookup_ns_per_name\n");
+    Timing results[] = {
+        time_symbols<char, core::StdMap>(names, exprs, iterations),
+        time_symbols<char, core::FlatMap>(names, exprs, iterations),
+        time_symbols<char, core::AsciiMap>(names, exprs, iterations),
+        time_symbols<wchar_t, core::StdMap>(names, exprs, iterations),
+        time_symbols<wchar_t, core::FlatMap>(names, exprs, iterations),
+        time_symbols<wchar_t, core::AsciiMap>(names, exprs, iterations),
+    };
+    const char *keys[] = {"char", "wchar_t"};
+    const char *maps[] = {"StdMap", "FlatMap", "AsciiMap"};
+    for (int i = 0; i < 6; ++i)
+        std::printf("%s,%s,%.3f,%.1f,%.2f\n", keys[i / 3], maps[i % 3], results[i].parse_ns_per_char,
+                    1e3 / results[i].parse_ns_per_char, results[i].lookup_ns_per_name);
+    return 0;
+}
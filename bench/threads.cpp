@@ -0,0 +1,59 @@
+#include "../include/eval.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// Evaluations per second with threads sharing one program, each with its own Workspace and Frame
+static double throughput(const core::Program<double> &program, std::size_t x_slot, unsigned threads,
+                         int iterations)
+{
+    std::vector<double> sums(threads * 8);//one cache line apart
+    auto worker = [&](unsigned id)
+    {
+        core::Workspace<double> ws(program);
+        core::Frame<double> frame(program);
+        double sum = 0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            frame[x_slot] = id + i * 1e-6;
+            sum += program.value(ws, frame);
+        }
+        sums[id * 8] = sum;
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned id = 0; id < threads; ++id)
+        pool.emplace_back(worker, id);
+    for (auto &t : pool)
+        t.join();
+    auto end = std::chrono::steady_clock::now();
+    return threads * static_cast<double>(iterations) / std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    Evaluator<char, double> eval;
+    eval.add_variable("x", 0.0);
+    eval.add_variable("y", 1.25);
+    auto program = eval.parse("sin(x)*cos(y)+sqrt(x*x+y*y)-x/(1+y*y)");
+    const auto x_slot = program.slot_of(eval.find_variable("x"));
+
+    std::printf("threads,evals_per_sec,speedup,efficiency\n");
+    const double single = throughput(program, x_slot, 1, iterations);
+    for (unsigned threads = 1; threads <= hardware; threads *= 2)
+    {
+        double rate = threads == 1 ? single : throughput(program, x_slot, threads, iterations);
+        std::printf("%u,%.0f,%.2f,%.2f\n", threads, rate, rate / single, rate / single / threads);
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+# Runs PROGRAM with ARGS (and FORMAT, for programs that take one after the iterations)
+# and stores its standard output in OUTPUT
+set(arguments ${ARGS})
+if(FORMAT)
+    if(NOT arguments)
+        set(arguments 0)
+    endif()
+    list(APPEND arguments ${FORMAT})
+endif()
+get_filename_component(directory ${OUTPUT} DIRECTORY)
+file(MAKE_DIRECTORY ${directory})
+message(STATUS "Running ${PROGRAM} ${arguments}")
+execute_process(COMMAND ${PROGRAM} ${arguments} OUTPUT_FILE ${OUTPUT} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM} failed: ${result}")
+endif()
@@ -0,0 +1,31 @@
+#define EVAL_COUNT_ALLOCATIONS //由 eval_instrument.hpp 替换全局 operator new/delete，数一下申请了几次堆内存
+#include "../include/eval.hpp"
+#include "../include/eval_instrument.hpp"
+#include <iostream>
+
+int main()
+{
+    using namespace ydog01;
+    using namespace ydog01::eval;
+    Evaluator<char, double> eval;
+    eval.add_variable("x", 0.0);
+    auto &x = eval.get_variable("x");
+
+    auto program = eval.parse("sin(x)*cos(x)+x^2/(1+x)-sqrt(x+1)*3");//先编译成扁平的程序
+    core::Workspace<double> ws(program);//工作区按程序的最大栈深度分配一次，之后反复使用
+
+    double sum = 0;
+    auto loop = core::count_allocations(
+        [&]()
+        {
+            for (int i = 0; i < 100000; ++i)
+            {
+                x = i * 0.001;
+                sum += program.value(ws);//这里不会再申请堆内存
+            }
+        });
+
+    std::cout << "sum = " << sum << std::endl;
+    std::cout << "allocations in loop: " << loop.allocations << std::endl;//应该是0
+    return loop.allocations == 0 ? 0 : 1;
+}
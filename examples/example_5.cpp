@@ -0,0 +1,84 @@
+// 需要 C++17：g++ -std=c++17 example_5.cpp
+// 目标平台有 FMA（比如 -march=native）时再加 -ffp-contract=off，否则 a*b+c 会被合成一条指令，结果差最后一位
+#include "../include/eval.hpp"
+#include "../include/eval_static.hpp"
+#include <cstring>
+#include <iostream>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// 参数表，编译期公式按这个顺序接收 x, y, z
+static constexpr char params[] = "x,y,z";
+
+// 公式必须是有静态存储期的字符数组，才能作为模板参数
+static constexpr char f0[] = "x+y*z";
+static constexpr char f1[] = "-x^2+y";
+static constexpr char f2[] = "2^-x*3";
+static constexpr char f3[] = "x^y^z";
+static constexpr char f4[] = "(x+y)*(x-y)/(z+1)";
+static constexpr char f5[] = "sin(x)*cos(y)+tan(z)";
+static constexpr char f6[] = "atan2(y, x) + hypot(x, y)";
+static constexpr char f7[] = "log(2, x*x+1) - ln(y+2) + log10(z+3)";
+static constexpr char f8[] = "exp(-x*x/2)/sqrt(2*pi)";
+static constexpr char f9[] = "sqrt x + 1";
+static constexpr char f10[] = "0.1+0.2+x*0.3";
+static constexpr char f11[] = "3.14159265358979323846*x + 123456789012345678901";
+static constexpr char f12[] = "x % 0.7 + floor(y*10)/10 + round(z) + trunc(-z) + ceil(x)";
+static constexpr char f13[] = "e^x - exp(x) + pi";
+static constexpr char f14[] = "abs(-x) + cbrt(y) + exp2(z) + log2(x+2) + log1p(y+1)";
+static constexpr char f15[] = "sinh(x)+cosh(y)+tanh(z)+asinh(x)+atanh(z/3)+acosh(y+2)";
+static constexpr char f16[] = "asin(z/3)+acos(z/4)+atan(x*y)";
+static constexpr char f17[] = "erf(x)+erfc(y)+tgamma(z+1.5)+lgamma(x+2)";
+static constexpr char f18[] = "--x - +y";
+static constexpr char f19[] = "((((x))))*(((y)+z))";
+static constexpr char f20[] = "3*x^4-2*x^3+x^2-7*x+5";
+static constexpr char f21[] = "1/3 + 2/7 + 0.000001 + 1234.5678";
+static constexpr char f22[] = "x*1e-9 + 2.5E+3*y - 0x1.8p3*z + 0xff";
+static constexpr char f23[] = "1e-30*x + 123456789.123456789e-3*y + 0x1.fffffffffffffp-1 + 0x3p-1074*z + 1e308";
+
+// 取一个公式，在网格上和运行期 Evaluator 逐位比较
+template <const char *F>
+static int check(Evaluator<char, double> &eval)
+{
+    StaticExpression<double, F, params> compiled;
+    auto program = eval.parse(F);
+    auto &x = eval.get_variable("x");
+    auto &y = eval.get_variable("y");
+    auto &z = eval.get_variable("z");
+    int mismatches = 0;
+    for (int i = -4; i <= 4; ++i)
+        for (int j = -2; j <= 3; ++j)
+            for (int k = -1; k <= 2; ++k)
+            {
+                x = i * 0.37;
+                y = j * 0.61;
+                z = k * 0.43;
+                double expected = program.value();
+                double actual = compiled(x, y, z);
+                if (std::memcmp(&expected, &actual, sizeof(double)))//NaN 也要逐位一致
+                    ++mismatches;
+            }
+    std::cout << (mismatches ? "MISMATCH " : "ok       ") << F << std::endl;
+    return mismatches;
+}
+
+int main()
+{
+    Evaluator<char, double> eval(Options::All);
+    eval.add_variable("x", 0.0);
+    eval.add_variable("y", 0.0);
+    eval.add_variable("z", 0.0);
+
+    int bad = check<f0>(eval) + check<f1>(eval) + check<f2>(eval) + check<f3>(eval) + check<f4>(eval) +
+              check<f5>(eval) + check<f6>(eval) + check<f7>(eval) + check<f8>(eval) + check<f9>(eval) +
+              check<f10>(eval) + check<f11>(eval) + check<f12>(eval) + check<f13>(eval) + check<f14>(eval) +
+              check<f15>(eval) + check<f16>(eval) + check<f17>(eval) + check<f18>(eval) + check<f19>(eval) +
+              check<f20>(eval) + check<f21>(eval) + check<f22>(eval) + check<f23>(eval);
+
+    // 零次运行期解析：公式在编译期就已经变成内联代码
+    static constexpr char quadratic[] = "a*x^2+b*x+c", quadratic_params[] = "x,a,b,c";
+    StaticExpression<double, quadratic, quadratic_params> q;
+    std::cout << "q(2, 1, -3, 2) = " << q(2.0, 1.0, -3.0, 2.0) << std::endl;//4-6+2=0
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#include "../include/eval.hpp"
+#include "../include/eval_autodiff.hpp"
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// 前向（derivative）和反向（gradient）都要和手算的导数一致，负底数也不能出 NaN
+static int check(const std::string &name, core::AutoDiff<double> &ad, double *x,
+                 const std::function<double(double)> &expected)
+{
+    int mismatches = 0;
+    std::vector<double> gradient;
+    for (int i = -8; i <= 8; ++i)
+    {
+        *x = i * 0.35;
+        const double want = expected(*x);
+        const double forward = ad.derivative(0).derivative;
+        ad.gradient(gradient);
+        const double tolerance = 1e-12 * (std::fabs(want) + 1);
+        if (!(std::fabs(forward - want) <= tolerance) || !(std::fabs(gradient[0] - want) <= tolerance))
+            ++mismatches;
+    }
+    std::cout << (mismatches ? "MISMATCH " : "ok       ") << name << std::endl;
+    return mismatches;
+}
+
+int main()
+{
+    Evaluator<char, double> eval;
+    eval.add_variable("x", 0.0);
+    double *x = eval.find_variable("x");
+    int bad = 0;
+
+    // (x-1)^n：指数是常数，不该对它求偏导 r*log(x-1)
+    for (int n = 2; n <= 5; ++n)
+    {
+        core::AutoDiff<double> ad(eval.parse("(x-1)^" + std::to_string(n)));
+        bad += check("(x-1)^" + std::to_string(n), ad, x, [n](double v) { return n * std::pow(v - 1, n - 1); });
+    }
+
+    // 自定义中缀、后缀运算符也能设置导数
+    eval.add_infix("<*>", [](core::ParamViewer<double> a) { return a[0] * a[1] * a[1]; }, 20);
+    eval.set_derivative("<*>", [](core::ParamViewer<double> a, std::size_t i)
+                        { return i ? 2 * a[0] * a[1] : a[1] * a[1]; }, OperatorType::INFIX);
+    eval.add_suffix("'", [](core::ParamViewer<double> a) { return a[0] * a[0] * a[0]; }, 40);
+    eval.set_derivative("'", [](core::ParamViewer<double> a, std::size_t) { return 3 * a[0] * a[0]; },
+                        OperatorType::SUFFIX);
+
+    core::AutoDiff<double> infix(eval.parse("x <*> (x+1)"));
+    bad += check("x <*> (x+1)", infix, x, [](double v) { return (v + 1) * (v + 1) + 2 * v * (v + 1); });
+    core::AutoDiff<double> suffix(eval.parse("(x-2)' + x"));
+    bad += check("(x-2)' + x", suffix, x, [](double v) { return 3 * (v - 2) * (v - 2) + 1; });
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#include "../include/eval.hpp"
+#include "../include/eval_incremental.hpp"
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace ydog01;
+using namespace ydog01::eval;
+
+// 会改写参数的运算符（比如赋值 :=）在各条求值路径上结果必须一样：
+// 链表 Expression 是基准，扁平 Program、evaluate 和增量求值要和它一致，变量也要被改成同样的值
+static int check(Evaluator<char, double> &eval, const std::string &expr, double x0, double y0)
+{
+    double &x = eval.get_variable("x");
+    double &y = eval.get_variable("y");
+    x = x0, y = y0;
+    const double expected = eval.parse<std::shared_ptr>(expr).value();
+    const double want_x = x, want_y = y;
+
+    int mismatches = 0;
+    auto same = [&](double got)
+    {
+        if (got != expected || x != want_x || y != want_y)
+            ++mismatches;
+        x = x0, y = y0;
+    };
+    x = x0, y = y0;
+    same(eval.parse(expr).value());
+    same(eval.evaluate(expr));
+    same(eval.evaluate(expr));//第二次走缓存
+    core::IncrementalProgram<double> incremental(eval.parse(expr));
+    same(incremental.value());
+    same(incremental.value());//第二次只重算变了的部分
+    std::cout << (mismatches ? "MISMATCH " : "ok       ") << expr << std::endl;
+    return mismatches;
+}
+
+int main()
+{
+    Evaluator<char, double> eval(Options::All);
+    eval.add_variable("x", 0.0);
+    eval.add_variable("y", 0.0);
+    eval.add_infix(":=", [](core::ParamViewer<double> a) { return a[0] = a[1]; }, 0, core::Associativity::Right);
+
+    int bad = 0;
+    // 公共子表达式不能跨过不纯的运算符合并：两边的 x*x 不是同一个值
+    bad += check(eval, "x*x + (x := 3) + x*x", 2, 0);
+    bad += check(eval, "(y := x) + y*2", 2, 3);
+    bad += check(eval, "sin(x) + (x := x + 1) + sin(x)", 0.5, 0);
+    return bad ? 1 : 0;
+}
@@ -8,13 +8,20 @@
 #define EVAL_HPP
 
 #include "eval_core.hpp"
+#include "eval_image.hpp"
+#include "eval_optimize.hpp"
 #include "options.hpp"
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace ydog01
 {
@@ -34,14 +41,103 @@ namespace ydog01
             }
         };
 
+        struct CacheStats
+        {
+            std::size_t hits = 0;
+            std::size_t misses = 0;
+            std::size_t size = 0;
+        };
+
+        // Bounded LRU map from expression text to compiled program. Copies start empty, since
+        // the index holds iterators into the list it was built for
         template <typename KeyType, typename DataType>
+        class ProgramCache
+        {
+            using Entry = std::pair<std::basic_string<KeyType>, core::Program<DataType>>;
+
+            std::list<Entry> entries_;
+            std::unordered_map<std::basic_string<KeyType>, typename std::list<Entry>::iterator> index_;
+            std::size_t capacity_;
+
+        public:
+            explicit ProgramCache(std::size_t capacity) : capacity_(capacity)
+            {
+            }
+            ProgramCache(const ProgramCache &other) : capacity_(other.capacity_)
+            {
+            }
+            ProgramCache(ProgramCache &&) = default;
+            auto operator=(const ProgramCache &other) -> ProgramCache &
+            {
+                clear();
+                capacity_ = other.capacity_;
+                return *this;
+            }
+            auto operator=(ProgramCache &&) -> ProgramCache & = default;
+
+            // Marks the entry most recently used; nullptr when absent
+            auto find(const std::basic_string<KeyType> &key) -> core::Program<DataType> *
+            {
+                auto found = index_.find(key);
+                if (found == index_.end())
+                    return nullptr;
+                entries_.splice(entries_.begin(), entries_, found->second);
+                return &found->second->second;
+            }
+
+            auto insert(const std::basic_string<KeyType> &key, core::Program<DataType> program)
+                -> core::Program<DataType> &
+            {
+                entries_.emplace_front(key, std::move(program));
+                index_[key] = entries_.begin();
+                set_capacity(capacity_);
+                return entries_.front().second;
+            }
+
+            auto set_capacity(std::size_t capacity) -> void
+            {
+                capacity_ = capacity;
+                while (entries_.size() > capacity_)
+                {
+                    index_.erase(entries_.back().first);
+                    entries_.pop_back();
+                }
+            }
+
+            auto capacity() const -> std::size_t
+            {
+                return capacity_;
+            }
+
+            auto size() const -> std::size_t
+            {
+                return entries_.size();
+            }
+
+            auto clear() -> void
+            {
+                entries_.clear();
+                index_.clear();
+            }
+        };
+
+        // MapType is the child map of the symbol trie: core::StdMap, core::FlatMap or core::AsciiMap
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType = core::StdMap>
         class Evaluator
         {
-            template <typename KeyT, typename DataT>
-            using MapType = std::map<KeyT, DataT>;
             using Context = core::ParserContext<MapType, KeyType, DataType>;
 
             Context ctx_;
+            Options options_;
+
+            // evaluate() keeps compiled programs in a bounded LRU list; any change to the
+            // symbol trie bumps generation_ and the next lookup drops the stale entries
+            ProgramCache<KeyType, DataType> cache_{256};
+            std::size_t generation_ = 0;
+            std::size_t cache_generation_ = 0;
+            CacheStats cache_stats_;
+            core::Workspace<DataType> workspace_;
+            bool evaluating_ = false;//a user function calling evaluate() must not touch the running entry
 
             static auto to_string(const char *str) -> std::basic_string<KeyType>;
 
@@ -58,6 +154,16 @@ namespace ydog01
             auto set_variable(const std::basic_string<KeyType> &name, const DataType &val) -> void;
             auto find_variable(const std::basic_string<KeyType> &name) -> DataType *;
 
+            // Resolves name once; set/get through the handle skip the trie. Programs map the
+            // handle to their own slot with Program::slot_of(handle).
+            auto bind(const std::basic_string<KeyType> &name) -> core::VariableHandle<DataType>;
+            auto set(const core::VariableHandle<DataType> &var, const DataType &val) -> void;
+            auto get(const core::VariableHandle<DataType> &var) const -> const DataType &;
+
+            // Immutable named values; parsed as constants, so they take part in constant folding
+            auto add_constant(const std::basic_string<KeyType> &name, const DataType &val) -> void;
+            auto find_constant(const std::basic_string<KeyType> &name) const -> const DataType *;
+
             auto add_prefix(const std::basic_string<KeyType> &name,
                             std::function<DataType(core::ParamViewer<DataType>)> func, int prec,
                             core::Associativity assoc = core::Associativity::Right) -> void;
@@ -74,24 +180,90 @@ namespace ydog01
                               std::function<DataType(core::ParamViewer<DataType>)> func,
                               core::Associativity assoc = core::Associativity::Right) -> void;
 
+            // Partial derivative of a user operator by argument i, used by core::AutoDiff; functions
+            // are prefix operators, kind picks infix or suffix operators of the same name
+            auto set_derivative(const std::basic_string<KeyType> &name,
+                                std::function<DataType(core::ParamViewer<DataType>, std::size_t)> derivative,
+                                OperatorType::Kind kind = OperatorType::PREFIX) -> void;
+
             auto remove_variable(const std::basic_string<KeyType> &name) -> bool;
+            auto remove_constant(const std::basic_string<KeyType> &name) -> bool;
             auto remove_prefix(const std::basic_string<KeyType> &name) -> bool;
             auto remove_infix(const std::basic_string<KeyType> &name) -> bool;
             auto remove_suffix(const std::basic_string<KeyType> &name) -> bool;
 
-            template <template <typename> class PtrType = std::shared_ptr>
-            auto parse(const std::basic_string<KeyType> &expr) -> core::Expression<DataType, PtrType>;
+            // Parsing does not change the evaluator: threads may parse concurrently as long as
+            // nobody adds, removes or reconfigures symbols meanwhile. Syntax errors throw
+            // core::ParseError with the offset of the offending token.
+            auto parse(const std::basic_string<KeyType> &expr) const -> core::Program<DataType>;
+            // Parses with every allocation taken from arena; destroy the programs, then reset it once
+            auto parse(const std::basic_string<KeyType> &expr, core::Arena &arena) const -> core::Program<DataType>;
+            // Compiles several expressions into one program with an output per expression, in
+            // order. The optimizer sees them together, so terms shared between outputs are
+            // computed once; Program::values fills every output in one pass.
+            auto parse_outputs(const std::vector<std::basic_string<KeyType>> &exprs) const -> core::Program<DataType>;
 
+            template <template <typename> class PtrType>
+            auto parse(const std::basic_string<KeyType> &expr) const -> core::Expression<DataType, PtrType>;
+
+            // Not thread safe while the cache is on: every call updates the cache, its statistics
+            // and a shared workspace. Threads should share programs from parse() instead, or turn
+            // the cache off with set_cache_capacity(0).
             auto evaluate(const std::basic_string<KeyType> &expr) -> DataType;
             auto operator()(const std::basic_string<KeyType> &expr) -> DataType;
 
+            // Capacity 0 turns the evaluate() cache off; shrinking evicts least recently used entries
+            auto set_cache_capacity(std::size_t capacity) -> void;
+            auto clear_cache() -> void;
+            auto cache_stats() const -> CacheStats;
+
+            // Binds an input column to the slot of an existing variable for Program::value_batch
+            auto bind_column(const std::basic_string<KeyType> &name, const DataType *data, std::size_t size)
+                -> core::Binding<DataType>;
+            auto bind_column(const core::VariableHandle<DataType> &var, const DataType *data, std::size_t size) const
+                -> core::Binding<DataType>;
+
+            // Name op is registered under, empty when it is not in the trie (reverse lookup, linear in the trie)
+            auto operator_name(const core::Operator<DataType> &op) const -> std::basic_string<KeyType>;
+
+            // The symbol trie, for inspection (core::footprint in eval_instrument.hpp)
+            auto symbols() const -> const typename Context::NodeType &;
+
+            // Hash of the symbol table: every name with the kinds registered under it, plus
+            // precedence, associativity, arity and builtin code of operators. Function bodies and
+            // values are not covered.
+            auto fingerprint() const -> std::uint64_t;
+
+            // Stores programs parsed by this evaluator as one binary image (layout in
+            // eval_image.hpp), with variables and operators by name. Throws std::invalid_argument
+            // for a program using a symbol this evaluator does not hold.
+            auto save_image(const std::vector<core::Program<DataType>> &programs) const -> std::vector<char>;
+            // Rebuilds the programs of an image, e.g. a core::MappedFile, without parsing: names
+            // are resolved once, code and constants copied as they are. Throws std::runtime_error
+            // when fingerprint() differs from the writer's or the image is malformed.
+            auto load_image(const void *data, std::size_t size) -> std::vector<core::Program<DataType>>;
+            auto load_image(const void *data, std::size_t size, core::Arena &arena)
+                -> std::vector<core::Program<DataType>>;
+
             auto add_builtin_operators() -> void;
             auto add_builtin_constants() -> void;
             auto add_builtin_functions() -> void;
+
+        private:
+            auto optimize(core::Program<DataType> &program) const -> void;
+            auto load_programs(const void *data, std::size_t size, core::Arena *arena)
+                -> std::vector<core::Program<DataType>>;
+
+            // Calls fn(node, name) for every node of the trie that holds a symbol
+            template <typename Fn>
+            auto visit_symbols(Fn fn) const -> void;
+
+            template <std::size_t I>
+            auto mark_builtin(const std::basic_string<KeyType> &name, core::OpCode code) -> void;
         };
 
-        template <typename KeyType, typename DataType>
-        Evaluator<KeyType, DataType>::Evaluator(Options opt)
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        Evaluator<KeyType, DataType, MapType>::Evaluator(Options opt) : options_(opt)
         {
             using Opt = Options;
             if ((opt & Opt::WhitespaceSkip) != Opt::None)
@@ -108,9 +280,10 @@ namespace ydog01
                 add_builtin_functions();
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::enable_whitespace_skip(bool on) -> void
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::enable_whitespace_skip(bool on) -> void
         {
+            ++generation_;
             if (on)
                 ctx_.skip = [](core::ParserInfo<KeyType, DataType> &info) -> bool
                 {
@@ -137,47 +310,26 @@ namespace ydog01
                 ctx_.skip = nullptr;
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::enable_constant_parser(bool on) -> void
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::enable_constant_parser(bool on) -> void
         {
+            ++generation_;
             if (on)
-                ctx_.constant_parser = [](core::ParserInfo<KeyType, DataType> &info) -> std::unique_ptr<DataType>
+                ctx_.constant_parser = [](core::ParserInfo<KeyType, DataType> &info, DataType &value) -> bool
                 {
-                    auto start = info.pos;
-                    bool dot = false, digit = false;
-                    while (info.pos < info.keys.size())
-                    {
-                        KeyType c = info.keys[info.pos];
-                        if (c >= static_cast<KeyType>('0') && c <= static_cast<KeyType>('9'))
-                        {
-                            digit = true;
-                            ++info.pos;
-                        }
-                        else if (c == static_cast<KeyType>('.') && !dot)
-                        {
-                            dot = true;
-                            ++info.pos;
-                        }
-                        else
-                            break;
-                    }
-                    if (!digit)
-                    {
-                        info.pos = start;
-                        return nullptr;
-                    }
-                    auto val = core::make_unique<DataType>();
-                    std::basic_stringstream<KeyType> ss(info.keys.substr(start, info.pos - start));
-                    ss >> *val;
-                    return val;
+                    const KeyType *first = info.keys.data() + info.pos;
+                    auto end = core::parse_number(first, info.keys.data() + info.keys.size(), value);
+                    info.pos += static_cast<std::size_t>(end - first);
+                    return end != first;
                 };
             else
                 ctx_.constant_parser = nullptr;
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::enable_function_call(bool on) -> void
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::enable_function_call(bool on) -> void
         {
+            ++generation_;
             using namespace core;
             if (on)
             {
@@ -198,8 +350,7 @@ namespace ydog01
                         auto &top = info.stack.back();
                         if (top.first == left)
                             break;
-                        info.expression.index.emplace_back(TokenType::Operator);
-                        info.expression.operators.emplace_back(top);
+                        info.program.push_operator(top.first, top.second);
                         info.stack.pop_back();
                     }
                     if (info.stack.empty())
@@ -228,8 +379,7 @@ namespace ydog01
                         auto &top = info.stack.back();
                         if (top.first == left)
                             break;
-                        info.expression.index.emplace_back(TokenType::Operator);
-                        info.expression.operators.emplace_back(top);
+                        info.program.push_operator(top.first, top.second);
                         info.stack.pop_back();
                     }
                     if (info.stack.empty())
@@ -248,22 +398,24 @@ namespace ydog01
             }
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_variable(const std::basic_string<KeyType> &name, const DataType &val)
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_variable(const std::basic_string<KeyType> &name, const DataType &val)
             -> void
         {
+            ++generation_;
             ctx_.resource.insert(name)->template set_data<Context::variable_pos>(std::make_shared<DataType>(val));
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_variable(const std::basic_string<KeyType> &name, DataType *ptr) -> void
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_variable(const std::basic_string<KeyType> &name, DataType *ptr) -> void
         {
+            ++generation_;
             ctx_.resource.insert(name)->template set_data<Context::variable_pos>(
                 std::shared_ptr<DataType>(ptr, [](DataType *) {}));
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::get_variable(const std::basic_string<KeyType> &name) -> DataType &
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::get_variable(const std::basic_string<KeyType> &name) -> DataType &
         {
             auto node = ctx_.resource.search(name);
             if (!node || !node->template has_data<Context::variable_pos>())
@@ -271,8 +423,8 @@ namespace ydog01
             return *node->template get_data<Context::variable_pos>();
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::set_variable(const std::basic_string<KeyType> &name, const DataType &val)
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::set_variable(const std::basic_string<KeyType> &name, const DataType &val)
             -> void
         {
             auto node = ctx_.resource.search(name);
@@ -281,8 +433,8 @@ namespace ydog01
             *node->template get_data<Context::variable_pos>() = val;
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::find_variable(const std::basic_string<KeyType> &name) -> DataType *
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::find_variable(const std::basic_string<KeyType> &name) -> DataType *
         {
             auto node = ctx_.resource.search(name);
             if (!node || !node->template has_data<Context::variable_pos>())
@@ -290,11 +442,54 @@ namespace ydog01
             return node->template get_data<Context::variable_pos>().get();
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_prefix(const std::basic_string<KeyType> &name,
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::bind(const std::basic_string<KeyType> &name)
+            -> core::VariableHandle<DataType>
+        {
+            auto node = ctx_.resource.search(name);
+            if (!node || !node->template has_data<Context::variable_pos>())
+                throw std::runtime_error("Variable not found");
+            return core::VariableHandle<DataType>(node->template get_data<Context::variable_pos>());
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::set(const core::VariableHandle<DataType> &var, const DataType &val)
+            -> void
+        {
+            *var.get() = val;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::get(const core::VariableHandle<DataType> &var) const
+            -> const DataType &
+        {
+            return *var.get();
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_constant(const std::basic_string<KeyType> &name, const DataType &val)
+            -> void
+        {
+            ++generation_;
+            ctx_.resource.insert(name)->template set_data<Context::constant_pos>(std::make_shared<DataType>(val));
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::find_constant(const std::basic_string<KeyType> &name) const
+            -> const DataType *
+        {
+            auto node = ctx_.resource.search(name);
+            if (!node || !node->template has_data<Context::constant_pos>())
+                return nullptr;
+            return node->template get_data<Context::constant_pos>().get();
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_prefix(const std::basic_string<KeyType> &name,
                                                       std::function<DataType(core::ParamViewer<DataType>)> func,
                                                       int prec, core::Associativity assoc) -> void
         {
+            ++generation_;
             auto op = std::make_shared<core::OperatorEx<KeyType, DataType>>();
             op->function = func;
             op->precedence = prec;
@@ -304,11 +499,12 @@ namespace ydog01
             ctx_.resource.insert(name)->template set_data<Context::prefix_pos>(op);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_infix(const std::basic_string<KeyType> &name,
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_infix(const std::basic_string<KeyType> &name,
                                                      std::function<DataType(core::ParamViewer<DataType>)> func,
                                                      int prec, core::Associativity assoc) -> void
         {
+            ++generation_;
             auto op = std::make_shared<core::OperatorEx<KeyType, DataType>>();
             op->function = func;
             op->precedence = prec;
@@ -319,11 +515,12 @@ namespace ydog01
             ctx_.resource.insert(name)->template set_data<Context::infix_pos>(op);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_suffix(const std::basic_string<KeyType> &name,
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_suffix(const std::basic_string<KeyType> &name,
                                                       std::function<DataType(core::ParamViewer<DataType>)> func,
                                                       int prec, core::Associativity assoc) -> void
         {
+            ++generation_;
             auto op = std::make_shared<core::OperatorEx<KeyType, DataType>>();
             op->function = func;
             op->precedence = prec;
@@ -333,12 +530,13 @@ namespace ydog01
             ctx_.resource.insert(name)->template set_data<Context::suffix_pos>(op);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_function(const std::basic_string<KeyType> &name,
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_function(const std::basic_string<KeyType> &name,
                                                         std::function<DataType(core::ParamViewer<DataType>)> func,
                                                         core::Associativity assoc)
             -> void
         {
+            ++generation_;
             auto op = std::make_shared<core::OperatorEx<KeyType, DataType>>();
             op->function = func;
             op->assoc = assoc;
@@ -348,32 +546,425 @@ namespace ydog01
             ctx_.resource.insert(name)->template set_data<Context::prefix_pos>(op);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::remove_variable(const std::basic_string<KeyType> &name) -> bool
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::set_derivative(
+            const std::basic_string<KeyType> &name,
+            std::function<DataType(core::ParamViewer<DataType>, std::size_t)> derivative, OperatorType::Kind kind)
+            -> void
         {
+            // Programs share the operator, so the rule reaches those already parsed too
+            auto node = ctx_.resource.search(name);
+            std::shared_ptr<core::Operator<DataType>> op;
+            if (node)
+                switch (kind)
+                {
+                case OperatorType::PREFIX: op = node->template get_data<Context::prefix_pos>(); break;
+                case OperatorType::INFIX: op = node->template get_data<Context::infix_pos>(); break;
+                case OperatorType::SUFFIX: op = node->template get_data<Context::suffix_pos>(); break;
+                }
+            if (!op)
+                throw std::runtime_error("Operator not found");
+            op->derivative = std::move(derivative);
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::remove_variable(const std::basic_string<KeyType> &name) -> bool
+        {
+            ++generation_;
             return ctx_.resource.template remove<Context::variable_pos>(name);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::remove_prefix(const std::basic_string<KeyType> &name) -> bool
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::remove_constant(const std::basic_string<KeyType> &name) -> bool
+        {
+            ++generation_;
+            return ctx_.resource.template remove<Context::constant_pos>(name);
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::remove_prefix(const std::basic_string<KeyType> &name) -> bool
         {
+            ++generation_;
             return ctx_.resource.template remove<Context::prefix_pos>(name);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::remove_infix(const std::basic_string<KeyType> &name) -> bool
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::remove_infix(const std::basic_string<KeyType> &name) -> bool
         {
+            ++generation_;
             return ctx_.resource.template remove<Context::infix_pos>(name);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::remove_suffix(const std::basic_string<KeyType> &name) -> bool
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::remove_suffix(const std::basic_string<KeyType> &name) -> bool
         {
+            ++generation_;
             return ctx_.resource.template remove<Context::suffix_pos>(name);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_builtin_operators() -> void
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::operator_name(const core::Operator<DataType> &op) const
+            -> std::basic_string<KeyType>
+        {
+            using Node = typename Context::NodeType;
+            std::vector<std::pair<const Node *, std::basic_string<KeyType>>> pending;
+            pending.emplace_back(&ctx_.resource, std::basic_string<KeyType>());
+            while (!pending.empty())
+            {
+                auto entry = std::move(pending.back());
+                pending.pop_back();
+                const Node *node = entry.first;
+                if (node->template get_data<Context::prefix_pos>().get() == &op ||
+                    node->template get_data<Context::infix_pos>().get() == &op ||
+                    node->template get_data<Context::suffix_pos>().get() == &op)
+                    return entry.second;
+                for (const auto &child : node->get_child())
+                    pending.emplace_back(&child.second, entry.second + child.first);
+            }
+            return std::basic_string<KeyType>();
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::symbols() const -> const typename Context::NodeType &
+        {
+            return ctx_.resource;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        template <typename Fn>
+        auto Evaluator<KeyType, DataType, MapType>::visit_symbols(Fn fn) const -> void
+        {
+            using Node = typename Context::NodeType;
+            std::vector<std::pair<const Node *, std::basic_string<KeyType>>> pending;
+            pending.emplace_back(&ctx_.resource, std::basic_string<KeyType>());
+            while (!pending.empty())
+            {
+                auto entry = std::move(pending.back());
+                pending.pop_back();
+                const Node *node = entry.first;
+                if (node->template has_data<Context::prefix_pos>() || node->template has_data<Context::infix_pos>() ||
+                    node->template has_data<Context::suffix_pos>() ||
+                    node->template has_data<Context::variable_pos>() ||
+                    node->template has_data<Context::constant_pos>())
+                    fn(*node, entry.second);
+                for (const auto &child : node->get_child())
+                    pending.emplace_back(&child.second, entry.second + child.first);
+            }
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::fingerprint() const -> std::uint64_t
+        {
+            using Node = typename Context::NodeType;
+            using Op = core::OperatorEx<KeyType, DataType>;
+            auto hash_operator = [](std::uint64_t hash, char tag, const Op *op)
+            {
+                if (!op)
+                    return hash;
+                const std::int32_t assoc = static_cast<std::int32_t>(op->assoc);
+                const std::uint64_t arity = op->default_param_size;
+                hash = core::fnv1a(hash, &tag, 1);
+                hash = core::fnv1a(hash, &op->precedence, sizeof(op->precedence));
+                hash = core::fnv1a(hash, &assoc, sizeof(assoc));
+                hash = core::fnv1a(hash, &arity, sizeof(arity));
+                return core::fnv1a(hash, &op->code, sizeof(op->code));
+            };
+
+            // The trie may iterate in any order (AsciiMap), so hash the entries sorted by name
+            std::vector<std::pair<std::basic_string<KeyType>, std::uint64_t>> entries;
+            visit_symbols(
+                [&](const Node &node, const std::basic_string<KeyType> &name)
+                {
+                    std::uint64_t hash = core::fnv1a_basis;
+                    hash = hash_operator(hash, 'P', node.template get_data<Context::prefix_pos>().get());
+                    hash = hash_operator(hash, 'I', node.template get_data<Context::infix_pos>().get());
+                    hash = hash_operator(hash, 'S', node.template get_data<Context::suffix_pos>().get());
+                    // Constant values are folded into the programs, only the names matter
+                    if (node.template has_data<Context::variable_pos>())
+                        hash = core::fnv1a(hash, "V", 1);
+                    if (node.template has_data<Context::constant_pos>())
+                        hash = core::fnv1a(hash, "C", 1);
+                    entries.emplace_back(name, hash);
+                });
+            std::sort(entries.begin(), entries.end());
+
+            const std::uint16_t sizes[2] = {sizeof(KeyType), sizeof(DataType)};
+            std::uint64_t hash = core::fnv1a(core::fnv1a_basis, sizes, sizeof(sizes));
+            for (const auto &entry : entries)
+            {
+                const std::uint64_t length = entry.first.size();
+                hash = core::fnv1a(hash, &length, sizeof(length));
+                hash = core::fnv1a(hash, entry.first.data(), length * sizeof(KeyType));
+                hash = core::fnv1a(hash, &entry.second, sizeof(entry.second));
+            }
+            return hash;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::save_image(const std::vector<core::Program<DataType>> &programs) const
+            -> std::vector<char>
+        {
+            static_assert(std::is_trivially_copyable<DataType>::value, "Images store constants as raw bytes");
+            using Node = typename Context::NodeType;
+            using Symbol = std::pair<core::SymbolKind, std::basic_string<KeyType>>;
+
+            std::unordered_map<const void *, Symbol> known;
+            visit_symbols(
+                [&](const Node &node, const std::basic_string<KeyType> &name)
+                {
+                    if (node.template has_data<Context::variable_pos>())
+                        known.emplace(node.template get_data<Context::variable_pos>().get(),
+                                      Symbol(core::SymbolKind::Variable, name));
+                    if (node.template has_data<Context::prefix_pos>())
+                        known.emplace(static_cast<const core::Operator<DataType> *>(
+                                          node.template get_data<Context::prefix_pos>().get()),
+                                      Symbol(core::SymbolKind::Prefix, name));
+                    if (node.template has_data<Context::infix_pos>())
+                        known.emplace(static_cast<const core::Operator<DataType> *>(
+                                          node.template get_data<Context::infix_pos>().get()),
+                                      Symbol(core::SymbolKind::Infix, name));
+                    if (node.template has_data<Context::suffix_pos>())
+                        known.emplace(static_cast<const core::Operator<DataType> *>(
+                                          node.template get_data<Context::suffix_pos>().get()),
+                                      Symbol(core::SymbolKind::Suffix, name));
+                });
+
+            // Name table, each symbol once however many programs use it
+            std::vector<core::ImageName> names;
+            std::vector<std::basic_string<KeyType>> texts;
+            std::unordered_map<const void *, std::uint32_t> index;
+            std::uint32_t builtins[256];
+            std::fill(std::begin(builtins), std::end(builtins), std::uint32_t(-1));
+            auto add_name = [&](core::SymbolKind kind, core::OpCode code, const std::basic_string<KeyType> &text)
+            {
+                core::ImageName name = core::ImageName();
+                name.kind = kind;
+                name.code = code;
+                name.length = static_cast<std::uint32_t>(text.size());
+                names.push_back(name);
+                texts.push_back(text);
+                return static_cast<std::uint32_t>(names.size() - 1);
+            };
+            auto symbol = [&](const void *ptr, const char *missing)
+            {
+                auto found = index.find(ptr);
+                if (found != index.end())
+                    return found->second;
+                auto entry = known.find(ptr);
+                if (entry == known.end())
+                    throw std::invalid_argument(missing);
+                const std::uint32_t i = add_name(entry->second.first, core::OpCode::None, entry->second.second);
+                index.emplace(ptr, i);
+                return i;
+            };
+
+            std::vector<std::vector<std::uint32_t>> refs(programs.size());
+            for (std::size_t p = 0; p < programs.size(); ++p)
+            {
+                for (const auto &var : programs[p].variables)
+                    refs[p].push_back(symbol(var.get(), "Variable not in the symbol table"));
+                for (const auto &op : programs[p].operators)
+                {
+                    if (!known.count(op.get()) && op->code != core::OpCode::None)
+                    {
+                        // Made by the optimizer, not registered anywhere: rebuilt from its code
+                        auto &slot = builtins[static_cast<std::uint8_t>(op->code)];
+                        if (slot == std::uint32_t(-1))
+                            slot = add_name(core::SymbolKind::Builtin, op->code, std::basic_string<KeyType>());
+                        refs[p].push_back(slot);
+                    }
+                    else
+                        refs[p].push_back(symbol(op.get(), "Operator not in the symbol table"));
+                }
+            }
+
+            core::ImageBuffer out;
+            core::ImageHeader header = core::ImageHeader();
+            std::copy(std::begin(core::image_magic), std::end(core::image_magic), header.magic);
+            header.version = core::image_version;
+            header.byte_order = 0x01020304u;
+            header.key_size = sizeof(KeyType);
+            header.data_size = sizeof(DataType);
+            header.fingerprint = fingerprint();
+            header.names = static_cast<std::uint32_t>(names.size());
+            header.programs = static_cast<std::uint32_t>(programs.size());
+            out.put(header);
+
+            out.align(core::image_align);
+            header.names_offset = out.size();
+            for (std::size_t i = 0; i < names.size(); ++i)
+            {
+                out.put(names[i]);
+                out.put(texts[i].data(), texts[i].size() * sizeof(KeyType));
+                out.align(8);
+            }
+
+            out.align(core::image_align);
+            header.directory_offset = out.size();
+            for (std::size_t p = 0; p < programs.size(); ++p)
+                out.put(std::uint64_t(0));
+
+            for (std::size_t p = 0; p < programs.size(); ++p)
+            {
+                const auto &program = programs[p];
+                out.align(core::image_align);
+                out.patch(header.directory_offset + p * sizeof(std::uint64_t), std::uint64_t(out.size()));
+                core::ImageProgram record = core::ImageProgram();
+                record.code = static_cast<std::uint32_t>(program.code.size());
+                record.constants = static_cast<std::uint32_t>(program.constants.size());
+                record.variables = static_cast<std::uint32_t>(program.variables.size());
+                record.operators = static_cast<std::uint32_t>(program.operators.size());
+                record.max_depth = static_cast<std::uint32_t>(program.max_depth);
+                record.temporaries = static_cast<std::uint32_t>(program.temporaries);
+                record.outputs = static_cast<std::uint32_t>(program.outputs);
+                out.put(record);
+                // Field by field into zeroed copies, so padding bytes do not make images differ
+                for (const auto &ins : program.code)
+                {
+                    core::Instruction stored;
+                    std::memset(&stored, 0, sizeof(stored));
+                    stored.type = ins.type;
+                    stored.code = ins.code;
+                    stored.size = ins.size;
+                    stored.operand = ins.operand;
+                    out.put(stored);
+                }
+                out.align(core::image_align);
+                for (const auto &value : program.constants)
+                {
+                    DataType stored;
+                    std::memset(&stored, 0, sizeof(stored));
+                    stored = value;
+                    out.put(stored);
+                }
+                out.put(refs[p].data(), refs[p].size() * sizeof(std::uint32_t));
+            }
+
+            header.size = out.size();
+            out.patch(0, header);
+            return out.release();
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::load_image(const void *data, std::size_t size)
+            -> std::vector<core::Program<DataType>>
+        {
+            return load_programs(data, size, nullptr);
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::load_image(const void *data, std::size_t size, core::Arena &arena)
+            -> std::vector<core::Program<DataType>>
+        {
+            return load_programs(data, size, &arena);
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::load_programs(const void *data, std::size_t size,
+                                                                  core::Arena *arena)
+            -> std::vector<core::Program<DataType>>
+        {
+            static_assert(std::is_trivially_copyable<DataType>::value, "Images store constants as raw bytes");
+            core::ImageView<KeyType, DataType> image(data, size);
+            if (image.header().fingerprint != fingerprint())
+                throw std::runtime_error("Image written for another symbol table");
+
+            // Resolve every name once; programs then only index these
+            const auto names = image.names();
+            std::vector<std::shared_ptr<DataType>> variables(names.size());
+            std::vector<std::shared_ptr<core::Operator<DataType>>> operators(names.size());
+            for (std::size_t i = 0; i < names.size(); ++i)
+            {
+                const auto &name = names[i];
+                if (name.kind == core::SymbolKind::Builtin)
+                {
+                    if (name.code == core::OpCode::None || name.code > core::OpCode::Lgamma)
+                        throw std::runtime_error("Malformed image");
+                    operators[i] = core::builtin_operator<DataType>(name.code);
+                    continue;
+                }
+                auto node = ctx_.resource.search(name.text);
+                if (node)
+                    switch (name.kind)
+                    {
+                    case core::SymbolKind::Variable:
+                        variables[i] = node->template get_data<Context::variable_pos>();
+                        break;
+                    case core::SymbolKind::Prefix:
+                        operators[i] = node->template get_data<Context::prefix_pos>();
+                        break;
+                    case core::SymbolKind::Infix:
+                        operators[i] = node->template get_data<Context::infix_pos>();
+                        break;
+                    case core::SymbolKind::Suffix:
+                        operators[i] = node->template get_data<Context::suffix_pos>();
+                        break;
+                    default:
+                        break;
+                    }
+                if (!variables[i] && !operators[i])
+                    throw std::runtime_error("Image refers to an unknown symbol");
+            }
+
+            std::vector<core::Program<DataType>> programs;
+            programs.reserve(image.header().programs);
+            for (std::size_t p = 0; p < image.header().programs; ++p)
+            {
+                const auto view = image.program(p);
+                // Each temporary is written by a Store, so there are never more than instructions
+                if (view.header->temporaries > view.header->code)
+                    throw std::runtime_error("Malformed image");
+                core::Program<DataType> program(arena);
+                program.code.assign(view.code, view.code + view.header->code);
+                program.constants.assign(view.constants, view.constants + view.header->constants);
+                program.variables.reserve(view.header->variables);
+                for (std::uint32_t i = 0; i < view.header->variables; ++i)
+                {
+                    if (view.variables[i] >= names.size() || !variables[view.variables[i]])
+                        throw std::runtime_error("Malformed image");
+                    program.variables.push_back(variables[view.variables[i]]);
+                }
+                program.operators.reserve(view.header->operators);
+                for (std::uint32_t i = 0; i < view.header->operators; ++i)
+                {
+                    if (view.operators[i] >= names.size() || !operators[view.operators[i]])
+                        throw std::runtime_error("Malformed image");
+                    program.operators.push_back(operators[view.operators[i]]);
+                }
+                program.temporaries = view.header->temporaries;
+                program.outputs = view.header->outputs;
+
+                // Operands must stay inside their pools and a native opcode must match both its
+                // argument count and the operator it stands for; finalize() then checks the stack effect
+                for (const auto &ins : program.code)
+                {
+                    std::size_t pool;
+                    switch (ins.type)
+                    {
+                    case core::TokenType::Constant: pool = program.constants.size(); break;
+                    case core::TokenType::Variale: pool = program.variables.size(); break;
+                    case core::TokenType::Operator: pool = program.operators.size(); break;
+                    case core::TokenType::Store:
+                    case core::TokenType::Load: pool = program.temporaries; break;
+                    default: throw std::runtime_error("Malformed image");
+                    }
+                    if (ins.operand >= pool || ins.code > core::OpCode::Lgamma)
+                        throw std::runtime_error("Malformed image");
+                    if (ins.type == core::TokenType::Operator && ins.code != core::OpCode::None &&
+                        (core::builtin_arity(ins.code) != ins.size || !core::native_builtin<DataType>(ins.code) ||
+                         program.operators[ins.operand]->code != ins.code))
+                        throw std::runtime_error("Malformed image");
+                }
+                if (!program.outputs)
+                    throw std::runtime_error("Malformed image");
+                program.finalize();
+                programs.push_back(std::move(program));
+            }
+            return programs;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_builtin_operators() -> void
         {
             add_infix(to_string("+"), [](core::ParamViewer<DataType> a) { return a[0] + a[1]; }, 10);
             add_infix(to_string("-"), [](core::ParamViewer<DataType> a) { return a[0] - a[1]; }, 10);
@@ -385,57 +976,90 @@ namespace ydog01
                 core::Associativity::Right);
             add_prefix(to_string("+"), [](core::ParamViewer<DataType> a) { return +a[0]; }, 40);
             add_prefix(to_string("-"), [](core::ParamViewer<DataType> a) { return -a[0]; }, 40);
+
+            mark_builtin<Context::infix_pos>(to_string("+"), core::OpCode::Add);
+            mark_builtin<Context::infix_pos>(to_string("-"), core::OpCode::Sub);
+            mark_builtin<Context::infix_pos>(to_string("*"), core::OpCode::Mul);
+            mark_builtin<Context::infix_pos>(to_string("/"), core::OpCode::Div);
+            mark_builtin<Context::infix_pos>(to_string("%"), core::OpCode::Mod);
+            mark_builtin<Context::infix_pos>(to_string("^"), core::OpCode::Pow);
+            mark_builtin<Context::prefix_pos>(to_string("+"), core::OpCode::Pos);
+            mark_builtin<Context::prefix_pos>(to_string("-"), core::OpCode::Neg);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_builtin_constants() -> void
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_builtin_constants() -> void
         {
-            static DataType pi_val = std::acos(DataType(-1));
-            static DataType e_val = std::exp(DataType(1));
-            add_variable(to_string("pi"), &pi_val);
-            add_variable(to_string("e"), &e_val);
+            add_constant(to_string("pi"), std::acos(DataType(-1)));
+            add_constant(to_string("e"), std::exp(DataType(1)));
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::add_builtin_functions() -> void
-        {
-            add_function(to_string("sin"), [](core::ParamViewer<DataType> a) { return std::sin(a[0]); });
-            add_function(to_string("cos"), [](core::ParamViewer<DataType> a) { return std::cos(a[0]); });
-            add_function(to_string("tan"), [](core::ParamViewer<DataType> a) { return std::tan(a[0]); });
-            add_function(to_string("asin"), [](core::ParamViewer<DataType> a) { return std::asin(a[0]); });
-            add_function(to_string("acos"), [](core::ParamViewer<DataType> a) { return std::acos(a[0]); });
-            add_function(to_string("atan"), [](core::ParamViewer<DataType> a) { return std::atan(a[0]); });
-            add_function(to_string("atan2"), [](core::ParamViewer<DataType> a) { return std::atan2(a[0], a[1]); });
-            add_function(to_string("sinh"), [](core::ParamViewer<DataType> a) { return std::sinh(a[0]); });
-            add_function(to_string("cosh"), [](core::ParamViewer<DataType> a) { return std::cosh(a[0]); });
-            add_function(to_string("tanh"), [](core::ParamViewer<DataType> a) { return std::tanh(a[0]); });
-            add_function(to_string("asinh"), [](core::ParamViewer<DataType> a) { return std::asinh(a[0]); });
-            add_function(to_string("acosh"), [](core::ParamViewer<DataType> a) { return std::acosh(a[0]); });
-            add_function(to_string("atanh"), [](core::ParamViewer<DataType> a) { return std::atanh(a[0]); });
-            add_function(to_string("exp"), [](core::ParamViewer<DataType> a) { return std::exp(a[0]); });
-            add_function(to_string("exp2"), [](core::ParamViewer<DataType> a) { return std::exp2(a[0]); });
-            add_function(to_string("ln"), [](core::ParamViewer<DataType> a) { return std::log(a[0]); });
-            add_function(to_string("log"),
-                         [](core::ParamViewer<DataType> a) { return std::log(a[1]) / std::log(a[0]); });
-            add_function(to_string("log10"), [](core::ParamViewer<DataType> a) { return std::log10(a[0]); });
-            add_function(to_string("log2"), [](core::ParamViewer<DataType> a) { return std::log2(a[0]); });
-            add_function(to_string("log1p"), [](core::ParamViewer<DataType> a) { return std::log1p(a[0]); });
-            add_function(to_string("sqrt"), [](core::ParamViewer<DataType> a) { return std::sqrt(a[0]); });
-            add_function(to_string("cbrt"), [](core::ParamViewer<DataType> a) { return std::cbrt(a[0]); });
-            add_function(to_string("hypot"), [](core::ParamViewer<DataType> a) { return std::hypot(a[0], a[1]); });
-            add_function(to_string("ceil"), [](core::ParamViewer<DataType> a) { return std::ceil(a[0]); });
-            add_function(to_string("floor"), [](core::ParamViewer<DataType> a) { return std::floor(a[0]); });
-            add_function(to_string("round"), [](core::ParamViewer<DataType> a) { return std::round(a[0]); });
-            add_function(to_string("trunc"), [](core::ParamViewer<DataType> a) { return std::trunc(a[0]); });
-            add_function(to_string("abs"), [](core::ParamViewer<DataType> a) { return std::abs(a[0]); });
-            add_function(to_string("erf"), [](core::ParamViewer<DataType> a) { return std::erf(a[0]); });
-            add_function(to_string("erfc"), [](core::ParamViewer<DataType> a) { return std::erfc(a[0]); });
-            add_function(to_string("tgamma"), [](core::ParamViewer<DataType> a) { return std::tgamma(a[0]); });
-            add_function(to_string("lgamma"), [](core::ParamViewer<DataType> a) { return std::lgamma(a[0]); });
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::add_builtin_functions() -> void
+        {
+            using core::OpCode;
+            static const std::pair<const char *, OpCode> table[] = {
+                {"sin", OpCode::Sin},       {"cos", OpCode::Cos},       {"tan", OpCode::Tan},
+                {"asin", OpCode::Asin},     {"acos", OpCode::Acos},     {"atan", OpCode::Atan},
+                {"atan2", OpCode::Atan2},   {"sinh", OpCode::Sinh},     {"cosh", OpCode::Cosh},
+                {"tanh", OpCode::Tanh},     {"asinh", OpCode::Asinh},   {"acosh", OpCode::Acosh},
+                {"atanh", OpCode::Atanh},   {"exp", OpCode::Exp},       {"exp2", OpCode::Exp2},
+                {"ln", OpCode::Ln},         {"log", OpCode::Log},       {"log10", OpCode::Log10},
+                {"log2", OpCode::Log2},     {"log1p", OpCode::Log1p},   {"sqrt", OpCode::Sqrt},
+                {"cbrt", OpCode::Cbrt},     {"hypot", OpCode::Hypot},   {"ceil", OpCode::Ceil},
+                {"floor", OpCode::Floor},   {"round", OpCode::Round},   {"trunc", OpCode::Trunc},
+                {"abs", OpCode::Abs},       {"erf", OpCode::Erf},       {"erfc", OpCode::Erfc},
+                {"tgamma", OpCode::Tgamma}, {"lgamma", OpCode::Lgamma}};
+
+            // The interpreter runs these natively; the std::function stays for calls with other arities
+            for (const auto &entry : table)
+            {
+                add_function(to_string(entry.first), core::builtin_operator<DataType>(entry.second)->function);
+                mark_builtin<Context::prefix_pos>(to_string(entry.first), entry.second);
+            }
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::to_string(const char *str) -> std::basic_string<KeyType>
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        template <std::size_t I>
+        auto Evaluator<KeyType, DataType, MapType>::mark_builtin(const std::basic_string<KeyType> &name, core::OpCode code)
+            -> void
+        {
+            auto op = ctx_.resource.search(name)->template get_data<I>();
+            op->code = code;
+            op->pure = true;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::optimize(core::Program<DataType> &program) const -> void
+        {
+            if ((options_ & Options::ConstantFolding) != Options::None)
+                core::fold_constants(program);
+            if ((options_ & Options::StrengthReduction) != Options::None)
+                core::reduce_strength(program, (options_ & Options::FastMath) != Options::None);
+            if ((options_ & Options::CommonSubexpressions) != Options::None)
+                core::eliminate_common_subexpressions(program);
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::bind_column(const std::basic_string<KeyType> &name, const DataType *data,
+                                                       std::size_t size) -> core::Binding<DataType>
+        {
+            auto slot = find_variable(name);
+            if (!slot)
+                throw std::runtime_error("Variable not found");
+            return core::Binding<DataType>{slot, data, size};
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::bind_column(const core::VariableHandle<DataType> &var,
+                                                                const DataType *data, std::size_t size) const
+            -> core::Binding<DataType>
+        {
+            return core::Binding<DataType>{var.get(), data, size};
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::to_string(const char *str) -> std::basic_string<KeyType>
         {
             std::basic_string<KeyType> result;
             while (*str)
@@ -443,22 +1067,130 @@ namespace ydog01
             return result;
         }
 
-        template <typename KeyType, typename DataType>
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::parse(const std::basic_string<KeyType> &expr) const -> core::Program<DataType>
+        {
+            auto program = ctx_.compile(expr);
+            optimize(program);
+            return program;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::parse(const std::basic_string<KeyType> &expr, core::Arena &arena) const
+            -> core::Program<DataType>
+        {
+            auto program = ctx_.compile(expr, arena);
+            optimize(program);
+            return program;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::parse_outputs(const std::vector<std::basic_string<KeyType>> &exprs) const
+            -> core::Program<DataType>
+        {
+            if (exprs.empty())
+                throw std::invalid_argument("No expressions to compile");
+            core::Program<DataType> program;
+            for (std::size_t i = 0; i < exprs.size(); ++i)
+            {
+                core::Program<DataType> part;
+                try
+                {
+                    part = ctx_.compile(exprs[i]);
+                }
+                catch (const core::ParseError &e)
+                {
+                    throw core::ParseError("Expression " + std::to_string(i) + ": " + e.what(), e.position());
+                }
+
+                // Append the part with its operands moved past the pools merged so far
+                const auto constants = static_cast<std::uint32_t>(program.constants.size());
+                const auto variables = static_cast<std::uint32_t>(program.variables.size());
+                const auto operators = static_cast<std::uint32_t>(program.operators.size());
+                for (auto ins : part.code)
+                {
+                    if (ins.type == core::TokenType::Constant)
+                        ins.operand += constants;
+                    else if (ins.type == core::TokenType::Variale)
+                        ins.operand += variables;
+                    else if (ins.type == core::TokenType::Operator)
+                        ins.operand += operators;
+                    program.code.push_back(ins);
+                }
+                program.constants.insert(program.constants.end(), part.constants.begin(), part.constants.end());
+                program.variables.insert(program.variables.end(), part.variables.begin(), part.variables.end());
+                program.operators.insert(program.operators.end(), part.operators.begin(), part.operators.end());
+            }
+            program.outputs = exprs.size();
+            program.finalize();
+            optimize(program);
+            return program;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
         template <template <typename> class PtrType>
-        auto Evaluator<KeyType, DataType>::parse(const std::basic_string<KeyType> &expr)
+        auto Evaluator<KeyType, DataType, MapType>::parse(const std::basic_string<KeyType> &expr) const
             -> core::Expression<DataType, PtrType>
         {
-            return ctx_.template parse<std::shared_ptr>(expr);
+            return ctx_.template parse<PtrType>(expr);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::evaluate(const std::basic_string<KeyType> &expr) -> DataType
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::evaluate(const std::basic_string<KeyType> &expr) -> DataType
         {
-            return ctx_.template parse<std::shared_ptr>(expr).value();
+            // Without the cache nothing of the evaluator is written, so threads may share it
+            if (!cache_.capacity())
+                return parse(expr).value();
+            if (evaluating_)
+            {
+                ++cache_stats_.misses;
+                return parse(expr).value();
+            }
+            struct Running
+            {
+                bool &flag;
+                ~Running()
+                {
+                    flag = false;
+                }
+            } running{evaluating_};
+            evaluating_ = true;
+            if (cache_generation_ != generation_)
+            {
+                cache_.clear();
+                cache_generation_ = generation_;
+            }
+            if (auto program = cache_.find(expr))
+            {
+                ++cache_stats_.hits;
+                return program->value(workspace_);
+            }
+            ++cache_stats_.misses;
+            return cache_.insert(expr, parse(expr)).value(workspace_);
         }
 
-        template <typename KeyType, typename DataType>
-        auto Evaluator<KeyType, DataType>::operator()(const std::basic_string<KeyType> &expr) -> DataType
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::set_cache_capacity(std::size_t capacity) -> void
+        {
+            cache_.set_capacity(capacity);
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::clear_cache() -> void
+        {
+            cache_.clear();
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::cache_stats() const -> CacheStats
+        {
+            CacheStats stats = cache_stats_;
+            stats.size = cache_.size();
+            return stats;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto Evaluator<KeyType, DataType, MapType>::operator()(const std::basic_string<KeyType> &expr) -> DataType
         {
             return evaluate(expr);
         }
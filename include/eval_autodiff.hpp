@@ -0,0 +1,305 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_AUTODIFF_HPP
+#define EVAL_AUTODIFF_HPP
+
+#include "eval_core.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace ydog01
+{
+    namespace core
+    {
+        // A value together with its derivative along some direction
+        template <typename DataType>
+        struct Dual
+        {
+            DataType value;
+            DataType derivative;
+        };
+
+        // psi(x), needed by tgamma and lgamma: reflection below 0, recurrence up to 10, then the asymptotic series
+        template <typename DataType>
+        auto digamma(DataType x) -> DataType
+        {
+            if (x <= 0 && x == std::floor(x))
+                return std::numeric_limits<DataType>::quiet_NaN();
+            const DataType pi = std::acos(DataType(-1));
+            if (x < 0)
+                return digamma(DataType(1) - x) - pi / std::tan(pi * x);
+            DataType result = 0;
+            for (; x < 10; x += 1)
+                result -= DataType(1) / x;
+            const DataType f = DataType(1) / (x * x);
+            return result + std::log(x) - DataType(0.5) / x -
+                   f * (DataType(1) / 12 -
+                        f * (DataType(1) / 120 - f * (DataType(1) / 252 - f * (DataType(1) / 240 - f / 132))));
+        }
+
+        // Partial derivative of a builtin by argument i, given its arguments x (and y) and its result r
+        template <typename DataType>
+        auto builtin_partial(OpCode code, std::size_t i, const DataType &x, const DataType &y, const DataType &r)
+            -> DataType
+        {
+            const DataType one(1), zero(0);
+            switch (code)
+            {
+            case OpCode::Add: return one;
+            case OpCode::Sub: return i ? -one : one;
+            case OpCode::Mul: return i ? x : y;
+            case OpCode::Div: return i ? -r / y : one / y;
+            case OpCode::Mod: return i ? -std::trunc(x / y) : one;
+            case OpCode::Pow: return i ? (x == zero ? zero : r * std::log(x)) : y * std::pow(x, y - one);
+            case OpCode::Pos: return one;
+            case OpCode::Neg: return -one;
+            case OpCode::Sin: return std::cos(x);
+            case OpCode::Cos: return -std::sin(x);
+            case OpCode::Tan: return one + r * r;
+            case OpCode::Asin: return one / std::sqrt(one - x * x);
+            case OpCode::Acos: return -one / std::sqrt(one - x * x);
+            case OpCode::Atan: return one / (one + x * x);
+            case OpCode::Atan2: return (i ? -x : y) / (x * x + y * y);
+            case OpCode::Sinh: return std::cosh(x);
+            case OpCode::Cosh: return std::sinh(x);
+            case OpCode::Tanh: return one - r * r;
+            case OpCode::Asinh: return one / std::sqrt(x * x + one);
+            case OpCode::Acosh: return one / std::sqrt(x * x - one);
+            case OpCode::Atanh: return one / (one - x * x);
+            case OpCode::Exp: return r;
+            case OpCode::Exp2: return r * std::log(DataType(2));
+            case OpCode::Ln: return one / x;
+            case OpCode::Log: return i ? one / (y * std::log(x)) : -r / (x * std::log(x)); // log(x, y) = ln y / ln x
+            case OpCode::Log10: return one / (x * std::log(DataType(10)));
+            case OpCode::Log2: return one / (x * std::log(DataType(2)));
+            case OpCode::Log1p: return one / (one + x);
+            case OpCode::Sqrt: return one / (r + r);
+            case OpCode::Cbrt: return one / (3 * r * r);
+            case OpCode::Hypot: return (i ? y : x) / r;
+            case OpCode::Ceil:
+            case OpCode::Floor:
+            case OpCode::Round:
+            case OpCode::Trunc: return zero;
+            case OpCode::Abs: return x > zero ? one : x < zero ? -one : zero;
+            case OpCode::Erf: return 2 / std::sqrt(std::acos(-one)) * std::exp(-x * x);
+            case OpCode::Erfc: return -2 / std::sqrt(std::acos(-one)) * std::exp(-x * x);
+            case OpCode::Tgamma: return r * digamma(x);
+            case OpCode::Lgamma: return digamma(x);
+            default: throw std::invalid_argument("Not a builtin");
+            }
+        }
+
+        // Differentiates a Program by its variable slots. Every instruction records its value and
+        // the partial derivatives by its operands; derivative() then carries tangents forward
+        // (dual numbers, one direction per pass) and gradient() carries adjoints backward over
+        // the same tape (every slot in one pass). Builtins use the rules above, user operators
+        // the Operator::derivative registered for them.
+        template <typename DataType>
+        class AutoDiff
+        {
+            Program<DataType> program_;
+            std::vector<std::size_t> args_;      // operand instructions of each instruction, flattened
+            std::vector<std::size_t> arg_begin_; // instruction i reads args_[arg_begin_[i], arg_begin_[i + 1])
+            std::vector<DataType> values_;
+            std::vector<DataType> partials_;     // d instruction / d operand, parallel to args_
+            std::vector<DataType> carry_;        // tangents or adjoints, one per instruction
+            std::vector<DataType> scratch_;
+            std::vector<DataType *> scratch_refs_;
+            std::size_t root_ = 0;
+
+            auto record() -> void;
+
+        public:
+            // Throws std::invalid_argument if a user operator has no derivative
+            explicit AutoDiff(Program<DataType> program);
+            AutoDiff(AutoDiff &&) = default;
+            auto operator=(AutoDiff &&) -> AutoDiff & = default;
+
+            // Value and directional derivative; direction holds one entry per variable slot
+            auto derivative(const std::vector<DataType> &direction) -> Dual<DataType>;
+            // Value and derivative by the variable in slot
+            auto derivative(std::size_t slot) -> Dual<DataType>;
+            // Returns the value; gradient[s] becomes the derivative by the variable in slot s
+            auto gradient(std::vector<DataType> &gradient) -> DataType;
+
+            auto program() const -> const Program<DataType> &;
+        };
+
+        template <typename DataType>
+        AutoDiff<DataType>::AutoDiff(Program<DataType> program)
+            : program_(std::move(program)), values_(program_.code.size()), carry_(program_.code.size())
+        {
+            // Same replay as IncrementalProgram: Store passes its value on, Load reads the latest Store
+            std::vector<std::size_t> stack;
+            std::vector<std::size_t> stores(program_.temporaries, 0);
+            std::size_t widest = 0;
+            arg_begin_.reserve(program_.code.size() + 1);
+            for (std::size_t i = 0; i < program_.code.size(); ++i)
+            {
+                const auto &ins = program_.code[i];
+                arg_begin_.push_back(args_.size());
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                case TokenType::Variale:
+                    stack.push_back(i);
+                    break;
+                case TokenType::Operator:
+                {
+                    if (ins.code == OpCode::None && !program_.operators[ins.operand]->derivative)
+                        throw std::invalid_argument("Operator without derivative");
+                    const std::size_t base = stack.size() - ins.size;
+                    args_.insert(args_.end(), stack.begin() + base, stack.end());
+                    stack.resize(base);
+                    stack.push_back(i);
+                    if (ins.size > widest)
+                        widest = ins.size;
+                    break;
+                }
+                case TokenType::Store:
+                    args_.push_back(stack.back());
+                    stack.back() = i;
+                    stores[ins.operand] = i;
+                    break;
+                case TokenType::Load:
+                    args_.push_back(stores[ins.operand]);
+                    stack.push_back(i);
+                    break;
+                }
+            }
+            arg_begin_.push_back(args_.size());
+            root_ = stack.front();//the first output, as value() returns
+            partials_.resize(args_.size());
+            scratch_.resize(widest);
+            scratch_refs_.resize(widest);
+            for (std::size_t i = 0; i < widest; ++i)
+                scratch_refs_[i] = &scratch_[i];
+        }
+
+        template <typename DataType>
+        auto AutoDiff<DataType>::record() -> void
+        {
+            for (std::size_t node = 0; node < program_.code.size(); ++node)
+            {
+                const auto &ins = program_.code[node];
+                const std::size_t *args = args_.data() + arg_begin_[node];
+                DataType *partials = partials_.data() + arg_begin_[node];
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                    values_[node] = program_.constants[ins.operand];
+                    break;
+                case TokenType::Variale:
+                    values_[node] = *program_.variables[ins.operand];
+                    break;
+                case TokenType::Store:
+                case TokenType::Load:
+                    values_[node] = values_[args[0]];
+                    partials[0] = DataType(1);
+                    break;
+                case TokenType::Operator:
+                    if (ins.code != OpCode::None)
+                    {
+                        const DataType &x = values_[args[0]];
+                        const DataType &y = ins.size == 2 ? values_[args[1]] : x;
+                        values_[node] = ins.size == 2 ? builtin_binary(ins.code, x, y) : builtin_unary(ins.code, x);
+                        // No partial by a constant operand: it would go unused, and some (the
+                        // r*log(x) of x^3 with x < 0) are NaN
+                        for (std::size_t j = 0; j < ins.size; ++j)
+                            partials[j] = program_.code[args[j]].type == TokenType::Constant
+                                              ? DataType(0)
+                                              : builtin_partial(ins.code, j, x, y, values_[node]);
+                    }
+                    else
+                    {
+                        // User operators may write to their arguments, so every call gets fresh copies
+                        const auto &op = *program_.operators[ins.operand];
+                        for (std::size_t j = 0; j < ins.size; ++j)
+                            scratch_[j] = values_[args[j]];
+                        values_[node] = op.function(ParamViewer<DataType>(scratch_refs_.data(), ins.size));
+                        for (std::size_t j = 0; j < ins.size; ++j)
+                        {
+                            partials[j] = DataType(0);
+                            if (program_.code[args[j]].type == TokenType::Constant)
+                                continue;
+                            for (std::size_t k = 0; k < ins.size; ++k)
+                                scratch_[k] = values_[args[k]];
+                            partials[j] = op.derivative(ParamViewer<DataType>(scratch_refs_.data(), ins.size), j);
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+
+        template <typename DataType>
+        auto AutoDiff<DataType>::derivative(const std::vector<DataType> &direction) -> Dual<DataType>
+        {
+            if (direction.size() < program_.variables.size())
+                throw std::invalid_argument("One direction entry per variable slot required");
+            record();
+            for (std::size_t node = 0; node < program_.code.size(); ++node)
+            {
+                const auto &ins = program_.code[node];
+                if (ins.type == TokenType::Variale)
+                {
+                    carry_[node] = direction[ins.operand];
+                    continue;
+                }
+                // Operands with a zero tangent are skipped, so a NaN or infinite partial by
+                // something the direction does not move cannot poison the sum
+                DataType tangent(0);
+                for (std::size_t j = arg_begin_[node]; j < arg_begin_[node + 1]; ++j)
+                    if (carry_[args_[j]] != DataType(0))
+                        tangent += partials_[j] * carry_[args_[j]];
+                carry_[node] = tangent;
+            }
+            return Dual<DataType>{values_[root_], carry_[root_]};
+        }
+
+        template <typename DataType>
+        auto AutoDiff<DataType>::derivative(std::size_t slot) -> Dual<DataType>
+        {
+            if (slot >= program_.variables.size())
+                throw std::out_of_range("Variable slot out of range");
+            std::vector<DataType> direction(program_.variables.size(), DataType(0));
+            direction[slot] = DataType(1);
+            return derivative(direction);
+        }
+
+        template <typename DataType>
+        auto AutoDiff<DataType>::gradient(std::vector<DataType> &gradient) -> DataType
+        {
+            record();
+            gradient.assign(program_.variables.size(), DataType(0));
+            std::fill(carry_.begin(), carry_.end(), DataType(0));
+            carry_[root_] = DataType(1);
+            for (std::size_t node = program_.code.size(); node-- > 0;)
+            {
+                const DataType adjoint = carry_[node];
+                if (program_.code[node].type == TokenType::Variale)
+                    gradient[program_.code[node].operand] += adjoint;
+                else if (adjoint != DataType(0))
+                    for (std::size_t j = arg_begin_[node]; j < arg_begin_[node + 1]; ++j)
+                        carry_[args_[j]] += partials_[j] * adjoint;
+            }
+            return values_[root_];
+        }
+
+        template <typename DataType>
+        auto AutoDiff<DataType>::program() const -> const Program<DataType> &
+        {
+            return program_;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_BULK_HPP
+#define EVAL_BULK_HPP
+
+#include "eval.hpp"
+#include "eval_parallel.hpp"
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Bulk compilation of formula files: one `name = expression` per line, blank lines and lines
+// starting with '#' skipped. The stream is read a few chunks of lines at a time and each round
+// of chunks is parsed on a core::ThreadPool against the evaluator's symbols, which must not
+// change during the load. A line that fails is reported and the load goes on.
+
+namespace ydog01
+{
+    namespace eval
+    {
+        template <typename KeyType, typename DataType>
+        struct Formula
+        {
+            std::basic_string<KeyType> name;
+            core::Program<DataType> program;
+            std::size_t line; // 1-based
+        };
+
+        struct FormulaError
+        {
+            std::size_t line;   // 1-based
+            std::size_t column; // 1-based, in the line as read
+            std::string message;
+        };
+
+        template <typename KeyType, typename DataType>
+        struct FormulaSet
+        {
+            std::vector<Formula<KeyType, DataType>> formulas; // in file order
+            std::vector<FormulaError> errors;                 // in file order
+        };
+
+        // Parses every formula of in; chunk_lines lines go to one task
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto load_formulas(const Evaluator<KeyType, DataType, MapType> &eval, std::basic_istream<KeyType> &in,
+                           core::ThreadPool &pool, std::size_t chunk_lines = 1024) -> FormulaSet<KeyType, DataType>;
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto load_formulas(const Evaluator<KeyType, DataType, MapType> &eval, const std::string &path,
+                           core::ThreadPool &pool, std::size_t chunk_lines = 1024) -> FormulaSet<KeyType, DataType>;
+
+        namespace bulk
+        {
+            template <typename KeyType>
+            struct Chunk
+            {
+                std::size_t first_line = 0;
+                std::vector<std::basic_string<KeyType>> lines;
+            };
+
+            template <typename KeyType>
+            auto is_space(KeyType c) -> bool
+            {
+                return c == KeyType(' ') || c == KeyType('\t') || c == KeyType('\r') || c == KeyType('\v') ||
+                       c == KeyType('\f');
+            }
+
+            // Parses one line into set; positions are counted from the start of the line
+            template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+            auto parse_line(const Evaluator<KeyType, DataType, MapType> &eval, const std::basic_string<KeyType> &text,
+                            std::size_t line, FormulaSet<KeyType, DataType> &set) -> void
+            {
+                std::size_t begin = 0, end = text.size();
+                while (begin < end && is_space(text[begin]))
+                    ++begin;
+                while (end > begin && is_space(text[end - 1]))
+                    --end;
+                if (begin == end || text[begin] == KeyType('#'))
+                    return;
+
+                const std::size_t equals = text.find(KeyType('='), begin);
+                if (equals >= end)
+                {
+                    set.errors.push_back(FormulaError{line, begin + 1, "Missing '=' after the formula name"});
+                    return;
+                }
+                std::size_t name_end = equals;
+                while (name_end > begin && is_space(text[name_end - 1]))
+                    --name_end;
+                if (name_end == begin)
+                {
+                    set.errors.push_back(FormulaError{line, equals + 1, "Missing formula name"});
+                    return;
+                }
+
+                const std::size_t expr_begin = equals + 1;
+                try
+                {
+                    auto program = eval.parse(text.substr(expr_begin, end - expr_begin));
+                    set.formulas.push_back(Formula<KeyType, DataType>{text.substr(begin, name_end - begin),
+                                                                      std::move(program), line});
+                }
+                catch (const core::ParseError &e)
+                {
+                    set.errors.push_back(FormulaError{line, expr_begin + e.position() + 1, e.what()});
+                }
+                catch (const std::exception &e)
+                {
+                    // Found after the whole expression was read, e.g. a missing operand
+                    set.errors.push_back(FormulaError{line, end + 1, e.what()});
+                }
+            }
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto load_formulas(const Evaluator<KeyType, DataType, MapType> &eval, std::basic_istream<KeyType> &in,
+                           core::ThreadPool &pool, std::size_t chunk_lines) -> FormulaSet<KeyType, DataType>
+        {
+            if (!chunk_lines)
+                chunk_lines = 1;
+            // A few chunks per thread in flight bounds memory to one round of text and results
+            const std::size_t round = pool.size() * 4;
+            FormulaSet<KeyType, DataType> result;
+            std::vector<bulk::Chunk<KeyType>> chunks(round);
+            std::vector<FormulaSet<KeyType, DataType>> parsed(round);
+            std::size_t line = 0;
+            bool more = true;
+            while (more)
+            {
+                std::size_t filled = 0;
+                for (; filled < round && more; ++filled)
+                {
+                    auto &chunk = chunks[filled];
+                    chunk.first_line = line + 1;
+                    chunk.lines.resize(chunk_lines);
+                    std::size_t count = 0;
+                    while (count < chunk_lines && std::getline(in, chunk.lines[count]))
+                        ++count;
+                    chunk.lines.resize(count);
+                    line += count;
+                    more = count == chunk_lines;
+                    if (!count)
+                        break;
+                }
+
+                pool.parallel_for(filled,
+                                  [&](std::size_t task)
+                                  {
+                                      const auto &chunk = chunks[task];
+                                      auto &set = parsed[task];
+                                      for (std::size_t i = 0; i < chunk.lines.size(); ++i)
+                                          bulk::parse_line(eval, chunk.lines[i], chunk.first_line + i, set);
+                                  });
+
+                for (std::size_t i = 0; i < filled; ++i)
+                {
+                    for (auto &formula : parsed[i].formulas)
+                        result.formulas.push_back(std::move(formula));
+                    result.errors.insert(result.errors.end(), parsed[i].errors.begin(), parsed[i].errors.end());
+                    parsed[i].formulas.clear();
+                    parsed[i].errors.clear();
+                }
+            }
+            if (in.bad())
+                throw std::runtime_error("Reading formulas failed");
+            return result;
+        }
+
+        template <typename KeyType, typename DataType, template <typename, typename> class MapType>
+        auto load_formulas(const Evaluator<KeyType, DataType, MapType> &eval, const std::string &path,
+                           core::ThreadPool &pool, std::size_t chunk_lines) -> FormulaSet<KeyType, DataType>
+        {
+            std::basic_ifstream<KeyType> in(path);
+            if (!in)
+                throw std::runtime_error("Cannot open " + path);
+            return load_formulas(eval, in, pool, chunk_lines);
+        }
+    }
+}
+
+#endif
@@ -9,16 +9,23 @@
 #ifndef EVAL_CORE
 #define EVAL_CORE
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <limits>
 #include <stdexcept>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 #include <tuple>
 #include <list>
+#include <map>
+#include <unordered_map>
 
 namespace ydog01
 {
@@ -30,6 +37,266 @@ namespace ydog01
             return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
         }
 
+        // Child maps for Node. Node only needs find/end, operator[], erase(key), empty, clear
+        // and iteration over pairs, so any map with that shape can be plugged in.
+
+        // The default: one heap node per child, pointer chasing on every lookup
+        template <typename KeyType, typename ValueType>
+        using StdMap = std::map<KeyType, ValueType>;
+
+        // Sorted vector of pairs: the children of a node sit in one block and are binary searched.
+        // Symbol tries are narrow below the root, so most lookups touch a single cache line.
+        template <typename KeyType, typename ValueType>
+        class FlatMap
+        {
+        public:
+            using value_type = std::pair<KeyType, ValueType>;
+            using iterator = typename std::vector<value_type>::iterator;
+            using const_iterator = typename std::vector<value_type>::const_iterator;
+
+            auto begin() -> iterator { return items_.begin(); }
+            auto end() -> iterator { return items_.end(); }
+            auto begin() const -> const_iterator { return items_.begin(); }
+            auto end() const -> const_iterator { return items_.end(); }
+
+            auto find(const KeyType &key) -> iterator
+            {
+                auto i = lower(key);
+                return i != items_.size() && !(key < items_[i].first) ? items_.begin() + i : items_.end();
+            }
+
+            auto find(const KeyType &key) const -> const_iterator
+            {
+                auto i = lower(key);
+                return i != items_.size() && !(key < items_[i].first) ? items_.begin() + i : items_.end();
+            }
+
+            auto operator[](const KeyType &key) -> ValueType &
+            {
+                auto i = lower(key);
+                if (i == items_.size() || key < items_[i].first)
+                    items_.insert(items_.begin() + i, value_type(key, ValueType()));
+                return items_[i].second;
+            }
+
+            auto erase(const KeyType &key) -> std::size_t
+            {
+                auto it = find(key);
+                if (it == items_.end())
+                    return 0;
+                items_.erase(it);
+                return 1;
+            }
+
+            auto empty() const -> bool { return items_.empty(); }
+            auto size() const -> std::size_t { return items_.size(); }
+            auto capacity() const -> std::size_t { return items_.capacity(); }
+            auto clear() -> void { items_.clear(); }
+
+        private:
+            std::vector<value_type> items_;
+
+            // Position of the first pair not below key
+            auto lower(const KeyType &key) const -> std::size_t
+            {
+                std::size_t first = 0, count = items_.size();
+                while (count)
+                {
+                    auto half = count / 2;
+                    if (items_[first + half].first < key)
+                    {
+                        first += half + 1;
+                        count -= half + 1;
+                    }
+                    else
+                        count = half;
+                }
+                return first;
+            }
+        };
+
+        // Unsorted vector of pairs behind a 128-entry table indexed by ASCII keys, so the common
+        // case is a single load. Other keys (wide characters beyond ASCII) use a linear scan.
+        // The table costs 256 bytes per node: it trades memory for the fastest tokenizer.
+        template <typename KeyType, typename ValueType>
+        class AsciiMap
+        {
+            static_assert(std::is_integral<KeyType>::value, "AsciiMap needs a character key");
+
+        public:
+            using value_type = std::pair<KeyType, ValueType>;
+            using iterator = typename std::vector<value_type>::iterator;
+            using const_iterator = typename std::vector<value_type>::const_iterator;
+
+            AsciiMap() { reset_slots(); }
+            AsciiMap(const AsciiMap &other) = default;
+            auto operator=(const AsciiMap &other) -> AsciiMap & = default;
+
+            AsciiMap(AsciiMap &&other) noexcept : items_(std::move(other.items_))
+            {
+                std::copy(other.slots_, other.slots_ + 128, slots_);
+                other.clear();
+            }
+
+            auto operator=(AsciiMap &&other) noexcept -> AsciiMap &
+            {
+                if (this != &other)
+                {
+                    items_ = std::move(other.items_);
+                    std::copy(other.slots_, other.slots_ + 128, slots_);
+                    other.clear();
+                }
+                return *this;
+            }
+
+            auto begin() -> iterator { return items_.begin(); }
+            auto end() -> iterator { return items_.end(); }
+            auto begin() const -> const_iterator { return items_.begin(); }
+            auto end() const -> const_iterator { return items_.end(); }
+
+            auto find(const KeyType &key) -> iterator
+            {
+                return items_.begin() + index(key);
+            }
+
+            auto find(const KeyType &key) const -> const_iterator
+            {
+                return items_.begin() + index(key);
+            }
+
+            auto operator[](const KeyType &key) -> ValueType &
+            {
+                auto i = index(key);
+                if (i == items_.size())
+                {
+                    if (is_ascii(key))
+                    {
+                        if (items_.size() >= 0xFFFF)
+                            throw std::length_error("AsciiMap node too wide");
+                        slots_[code(key)] = static_cast<std::uint16_t>(i + 1);
+                    }
+                    items_.push_back(value_type(key, ValueType()));
+                }
+                return items_[i].second;
+            }
+
+            // Moves the last pair into the hole, so only that one slot needs fixing
+            auto erase(const KeyType &key) -> std::size_t
+            {
+                auto i = index(key);
+                if (i == items_.size())
+                    return 0;
+                if (is_ascii(key))
+                    slots_[code(key)] = 0;
+                if (i + 1 != items_.size())
+                {
+                    items_[i] = std::move(items_.back());
+                    if (is_ascii(items_[i].first))
+                        slots_[code(items_[i].first)] = static_cast<std::uint16_t>(i + 1);
+                }
+                items_.pop_back();
+                return 1;
+            }
+
+            auto empty() const -> bool { return items_.empty(); }
+            auto size() const -> std::size_t { return items_.size(); }
+            auto capacity() const -> std::size_t { return items_.capacity(); }
+
+            auto clear() -> void
+            {
+                items_.clear();
+                reset_slots();
+            }
+
+        private:
+            std::vector<value_type> items_;
+            std::uint16_t slots_[128]; // index + 1 into items_, 0 when absent
+
+            static auto code(const KeyType &key) -> typename std::make_unsigned<KeyType>::type
+            {
+                return static_cast<typename std::make_unsigned<KeyType>::type>(key);
+            }
+
+            static auto is_ascii(const KeyType &key) -> bool
+            {
+                return code(key) < 128;
+            }
+
+            auto reset_slots() -> void
+            {
+                std::fill(slots_, slots_ + 128, std::uint16_t(0));
+            }
+
+            // Position of key in items_, items_.size() when absent
+            auto index(const KeyType &key) const -> std::size_t
+            {
+                if (is_ascii(key))
+                {
+                    auto slot = slots_[code(key)];
+                    return slot ? slot - 1u : items_.size();
+                }
+                std::size_t i = 0;
+                while (i < items_.size() && !(items_[i].first == key))
+                    ++i;
+                return i;
+            }
+        };
+
+        // Copy-on-write FlatMap: copies share one block until a side changes it, so copying a
+        // whole trie is O(1) and a later write copies only the maps along its path (structural
+        // sharing, see core::Published). Every non-const access detaches first, a non-const
+        // find() included. One copy must not be changed by two threads at once.
+        template <typename KeyType, typename ValueType>
+        class SharedMap
+        {
+            using Storage = FlatMap<KeyType, ValueType>;
+
+        public:
+            using value_type = typename Storage::value_type;
+            using iterator = typename Storage::iterator;
+            using const_iterator = typename Storage::const_iterator;
+
+            auto begin() -> iterator { return own().begin(); }
+            auto end() -> iterator { return own().end(); }
+            auto begin() const -> const_iterator { return view().begin(); }
+            auto end() const -> const_iterator { return view().end(); }
+
+            auto find(const KeyType &key) -> iterator { return own().find(key); }
+            auto find(const KeyType &key) const -> const_iterator { return view().find(key); }
+            auto operator[](const KeyType &key) -> ValueType & { return own()[key]; }
+
+            auto erase(const KeyType &key) -> std::size_t
+            {
+                return view().find(key) == view().end() ? 0 : own().erase(key);
+            }
+
+            auto empty() const -> bool { return view().empty(); }
+            auto size() const -> std::size_t { return view().size(); }
+            auto capacity() const -> std::size_t { return view().capacity(); }
+            auto clear() -> void { items_.reset(); }
+
+            // Maps holding the block, 0 while empty
+            auto shared() const -> std::size_t { return static_cast<std::size_t>(items_.use_count()); }
+
+        private:
+            std::shared_ptr<Storage> items_;
+
+            auto view() const -> const Storage &
+            {
+                static const Storage none;
+                return items_ ? *items_ : none;
+            }
+
+            auto own() -> Storage &
+            {
+                if (!items_)
+                    items_ = std::make_shared<Storage>();
+                else if (items_.use_count() > 1)
+                    items_ = std::make_shared<Storage>(*items_);
+                return *items_;
+            }
+        };
+
         template <template <typename, typename> class MapType, typename KeyType, typename... DataType>
         class Node
         {
@@ -184,29 +451,667 @@ namespace ydog01
             Right
         };
 
+        // Monotonic allocator: carves allocations out of blocks and frees them all at once in
+        // reset(). An optional caller buffer, often on the stack, serves the first requests so
+        // small jobs never reach the heap. Not thread safe.
+        class Arena
+        {
+            struct Block
+            {
+                Block *next;
+                std::size_t size;
+            };
+
+            char *buffer_;
+            std::size_t buffer_size_;
+            Block *blocks_ = nullptr;
+            char *cur_;
+            char *end_;
+            std::size_t block_size_;
+            std::size_t used_ = 0;
+
+            auto grow(std::size_t bytes) -> void;
+            auto release(Block *keep) -> void;
+
+        public:
+            explicit Arena(std::size_t block_size = 4096);
+            Arena(void *buffer, std::size_t size, std::size_t block_size = 4096);
+            Arena(const Arena &) = delete;
+            auto operator=(const Arena &) -> Arena & = delete;
+            ~Arena();
+
+            auto allocate(std::size_t bytes, std::size_t align) -> void *;
+
+            // Invalidates every allocation at once; the largest block is kept for reuse.
+            // Objects living in the arena must be destroyed first, their destructors are not run.
+            auto reset() -> void;
+
+            // Bytes handed out since the last reset
+            auto used() const -> std::size_t;
+            // Heap blocks currently held
+            auto blocks() const -> std::size_t;
+        };
+
+        // std allocator over an Arena; deallocation is a no-op. Without an arena it forwards to
+        // operator new, so containers using it behave like ordinary ones until one is attached.
+        template <typename T>
+        class ArenaAllocator
+        {
+            Arena *arena_ = nullptr;
+
+        public:
+            using value_type = T;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+
+            ArenaAllocator() = default;
+            explicit ArenaAllocator(Arena *arena) noexcept : arena_(arena) {}
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.arena()) {}
+
+            auto allocate(std::size_t n) -> T *
+            {
+                if (arena_)
+                    return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            }
+
+            auto deallocate(T *p, std::size_t) noexcept -> void
+            {
+                if (!arena_)
+                    ::operator delete(p);
+            }
+
+            // Copies of a container go to the heap, so they survive a reset of the arena
+            auto select_on_container_copy_construction() const -> ArenaAllocator
+            {
+                return ArenaAllocator();
+            }
+
+            auto arena() const noexcept -> Arena *
+            {
+                return arena_;
+            }
+        };
+
+        template <typename T, typename U>
+        auto operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) noexcept -> bool
+        {
+            return a.arena() == b.arena();
+        }
+
+        template <typename T, typename U>
+        auto operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) noexcept -> bool
+        {
+            return a.arena() != b.arena();
+        }
+
+        template <typename T>
+        using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+        // Significant digits of a numeric literal with the point taken out:
+        // value = digits * 10^exponent, or digits * 2^exponent for hexadecimal literals
+        struct NumberText
+        {
+            // More digits never change a correctly rounded long double, only whether any follow
+            static constexpr std::size_t max_digits = 800;
+
+            char digits[max_digits + 2];
+            std::size_t count = 0;
+            bool inexact = false; // nonzero digits were dropped after max_digits
+            bool hex = false;
+            long exponent = 0;
+        };
+
+        // Reads a literal at [first, last): decimal with optional fraction and exponent (7, 2.5,
+        // .5, 1e-9) or hexadecimal with optional fraction and binary exponent (0xff, 0x1.8p3).
+        // Returns the end of the literal, first when there is none. Floating point results are
+        // correctly rounded and independent of the locale; other types are built from a long
+        // double when they can be (integers saturating at their range), and read with a stream
+        // otherwise.
+        template <typename CharType, typename DataType>
+        auto parse_number(const CharType *first, const CharType *last, DataType &value) -> const CharType *;
+
+        template <typename CharType>
+        auto scan_number(const CharType *first, const CharType *last, NumberText &text) -> const CharType *
+        {
+            auto hex_digit = [](CharType c) -> int
+            {
+                if (c >= CharType('0') && c <= CharType('9'))
+                    return static_cast<int>(c - CharType('0'));
+                if (c >= CharType('a') && c <= CharType('f'))
+                    return static_cast<int>(c - CharType('a')) + 10;
+                if (c >= CharType('A') && c <= CharType('F'))
+                    return static_cast<int>(c - CharType('A')) + 10;
+                return -1;
+            };
+            auto p = first;
+            if (last - p > 2 && p[0] == CharType('0') && (p[1] == CharType('x') || p[1] == CharType('X')) &&
+                (hex_digit(p[2]) >= 0 || (p[2] == CharType('.') && last - p > 3 && hex_digit(p[3]) >= 0)))
+            {
+                text.hex = true;
+                p += 2;
+            }
+            const long step = text.hex ? 4 : 1;
+            bool any = false, dot = false;
+            for (; p < last; ++p)
+            {
+                if (*p == CharType('.') && !dot)
+                {
+                    dot = true;
+                    continue;
+                }
+                int d = hex_digit(*p);
+                if (d < 0 || (!text.hex && d > 9))
+                    break;
+                any = true;
+                if (!text.count && !d)
+                {
+                    if (dot)
+                        text.exponent -= step;
+                }
+                else if (text.count < NumberText::max_digits)
+                {
+                    text.digits[text.count++] = "0123456789abcdef"[d];
+                    if (dot)
+                        text.exponent -= step;
+                }
+                else
+                {
+                    text.inexact = text.inexact || d;
+                    if (!dot)
+                        text.exponent += step;
+                }
+            }
+            if (!any)
+                return first;
+
+            // An exponent only counts when digits follow it, so "2e" stays a 2
+            const CharType marker = text.hex ? CharType('p') : CharType('e');
+            if (p < last && (*p == marker || *p == marker - CharType('a' - 'A')))
+            {
+                auto q = p + 1;
+                bool negative = false;
+                if (q < last && (*q == CharType('+') || *q == CharType('-')))
+                    negative = *q++ == CharType('-');
+                if (q < last && *q >= CharType('0') && *q <= CharType('9'))
+                {
+                    long exponent = 0;
+                    for (; q < last && *q >= CharType('0') && *q <= CharType('9'); ++q)
+                        if (exponent < 100000)
+                            exponent = exponent * 10 + static_cast<long>(*q - CharType('0'));
+                    text.exponent += negative ? -exponent : exponent;
+                    p = q;
+                }
+            }
+            return p;
+        }
+
+        inline auto strto_floating(const char *text, float &value) -> void
+        {
+            value = std::strtof(text, nullptr);
+        }
+
+        inline auto strto_floating(const char *text, double &value) -> void
+        {
+            value = std::strtod(text, nullptr);
+        }
+
+        inline auto strto_floating(const char *text, long double &value) -> void
+        {
+            value = std::strtold(text, nullptr);
+        }
+
+        // 10^0 .. 10^k for the largest k where 10^k = 2^k * 5^k is exact in T, i.e. 5^k fits the mantissa
+        template <typename T>
+        auto exact_pow10() -> const std::vector<T> &
+        {
+            static const std::vector<T> powers = []()
+            {
+                const int digits = std::numeric_limits<T>::digits < 64 ? std::numeric_limits<T>::digits : 64;
+                std::vector<T> result(1, T(1));
+                std::uint64_t five = 1;
+                while (five <= std::numeric_limits<std::uint64_t>::max() / 5 && !(five * 5 >> (digits - 1) >> 1))
+                {
+                    five *= 5;
+                    result.push_back(result.back() * T(10));
+                }
+                return result;
+            }();
+            return powers;
+        }
+
+        template <typename T>
+        auto number_value(NumberText &text, T &value) -> typename std::enable_if<std::is_floating_point<T>::value>::type
+        {
+            if (!text.count)
+            {
+                value = T(0);
+                return;
+            }
+            const int digits = std::numeric_limits<T>::digits;
+            if (!text.inexact && text.count <= 16)
+            {
+                std::uint64_t mantissa = 0;
+                for (std::size_t i = 0; i < text.count; ++i)
+                    mantissa = mantissa * (text.hex ? 16 : 10) +
+                               static_cast<std::uint64_t>(text.digits[i] <= '9' ? text.digits[i] - '0'
+                                                                                : text.digits[i] - 'a' + 10);
+                if (!(mantissa >> (digits < 64 ? digits - 1 : 63) >> 1))
+                {
+                    // Clinger's fast path: the mantissa and the power of ten are exact
+                    if (text.hex)
+                    {
+                        value = std::ldexp(static_cast<T>(mantissa), static_cast<int>(text.exponent));
+                        return;
+                    }
+                    const auto &powers = exact_pow10<T>();
+                    const auto limit = static_cast<long>(powers.size()) - 1;
+                    if (text.exponent >= -limit && text.exponent <= limit)
+                    {
+                        value = text.exponent < 0 ? static_cast<T>(mantissa) / powers[-text.exponent]
+                                                  : static_cast<T>(mantissa) * powers[text.exponent];
+                        return;
+                    }
+                }
+            }
+
+            // Slow path: strto* on the digits without a decimal point, which no locale changes;
+            // a trailing 1 stands for the dropped digits so rounding still sees them
+            if (text.inexact)
+            {
+                text.digits[text.count++] = '1';
+                text.exponent -= text.hex ? 4 : 1;
+            }
+            char buffer[NumberText::max_digits + 16];
+            char *out = buffer;
+            if (text.hex)
+            {
+                *out++ = '0';
+                *out++ = 'x';
+            }
+            std::copy(text.digits, text.digits + text.count, out);
+            out += text.count;
+            *out++ = text.hex ? 'p' : 'e';
+            long exponent = text.exponent;
+            if (exponent < 0)
+            {
+                *out++ = '-';
+                exponent = -exponent;
+            }
+            char reversed[24];
+            int n = 0;
+            do
+                reversed[n++] = static_cast<char>('0' + exponent % 10);
+            while (exponent /= 10);
+            while (n)
+                *out++ = reversed[--n];
+            *out = '\0';
+            strto_floating(buffer, value);
+        }
+
+        template <typename CharType, typename DataType>
+        auto read_number(NumberText &text, const CharType *, const CharType *, DataType &value)
+            -> typename std::enable_if<std::is_floating_point<DataType>::value>::type
+        {
+            number_value(text, value);
+        }
+
+        // Integers saturate at the ends of their range, as strtol does, instead of overflowing
+        // the conversion from long double; a max() that rounds up as a long double still
+        // compares correctly since the test is >=
+        template <typename DataType>
+        auto narrow_number(long double wide) -> typename std::enable_if<std::is_integral<DataType>::value, DataType>::type
+        {
+            if (wide >= static_cast<long double>(std::numeric_limits<DataType>::max()))
+                return std::numeric_limits<DataType>::max();
+            if (wide <= static_cast<long double>(std::numeric_limits<DataType>::lowest()))
+                return std::numeric_limits<DataType>::lowest();
+            return static_cast<DataType>(wide);
+        }
+
+        template <typename DataType>
+        auto narrow_number(long double wide) -> typename std::enable_if<!std::is_integral<DataType>::value, DataType>::type
+        {
+            return DataType(wide);
+        }
+
+        template <typename CharType, typename DataType>
+        auto read_number(NumberText &text, const CharType *, const CharType *, DataType &value)
+            -> typename std::enable_if<!std::is_floating_point<DataType>::value &&
+                                       std::is_constructible<DataType, long double>::value>::type
+        {
+            long double wide;
+            number_value(text, wide);
+            value = narrow_number<DataType>(wide);
+        }
+
+        template <typename CharType, typename DataType>
+        auto read_number(NumberText &, const CharType *first, const CharType *last, DataType &value)
+            -> typename std::enable_if<!std::is_floating_point<DataType>::value &&
+                                       !std::is_constructible<DataType, long double>::value>::type
+        {
+            std::basic_stringstream<CharType> stream(std::basic_string<CharType>(first, last));
+            stream >> value;
+        }
+
+        template <typename CharType, typename DataType>
+        auto parse_number(const CharType *first, const CharType *last, DataType &value) -> const CharType *
+        {
+            NumberText text;
+            auto end = scan_number(first, last, text);
+            if (end != first)
+                read_number(text, first, end, value);
+            return end;
+        }
+
+        inline Arena::Arena(std::size_t block_size)
+            : buffer_(nullptr), buffer_size_(0), cur_(nullptr), end_(nullptr), block_size_(block_size)
+        {
+        }
+
+        inline Arena::Arena(void *buffer, std::size_t size, std::size_t block_size)
+            : buffer_(static_cast<char *>(buffer)), buffer_size_(size), cur_(buffer_), end_(buffer_ + size),
+              block_size_(block_size)
+        {
+        }
+
+        inline Arena::~Arena()
+        {
+            release(nullptr);
+        }
+
+        inline auto Arena::allocate(std::size_t bytes, std::size_t align) -> void *
+        {
+            auto p = (reinterpret_cast<std::uintptr_t>(cur_) + align - 1) & ~(std::uintptr_t(align) - 1);
+            if (!cur_ || p + bytes > reinterpret_cast<std::uintptr_t>(end_))
+            {
+                grow(bytes + align);
+                p = (reinterpret_cast<std::uintptr_t>(cur_) + align - 1) & ~(std::uintptr_t(align) - 1);
+            }
+            cur_ = reinterpret_cast<char *>(p + bytes);
+            used_ += bytes;
+            return reinterpret_cast<void *>(p);
+        }
+
+        // Blocks double in size, so a long parse costs a logarithmic number of mallocs
+        inline auto Arena::grow(std::size_t bytes) -> void
+        {
+            std::size_t size = block_size_;
+            while (size < bytes + sizeof(Block))
+                size *= 2;
+            block_size_ = size * 2;
+            auto block = static_cast<Block *>(::operator new(size));
+            block->next = blocks_;
+            block->size = size;
+            blocks_ = block;
+            cur_ = reinterpret_cast<char *>(block + 1);
+            end_ = reinterpret_cast<char *>(block) + size;
+        }
+
+        inline auto Arena::release(Block *keep) -> void
+        {
+            while (blocks_)
+            {
+                auto next = blocks_->next;
+                if (blocks_ != keep)
+                    ::operator delete(blocks_);
+                blocks_ = next;
+            }
+        }
+
+        inline auto Arena::reset() -> void
+        {
+            // The newest block is the largest one
+            auto keep = blocks_;
+            release(keep);
+            used_ = 0;
+            blocks_ = keep;
+            if (keep)
+            {
+                keep->next = nullptr;
+                cur_ = reinterpret_cast<char *>(keep + 1);
+                end_ = reinterpret_cast<char *>(keep) + keep->size;
+            }
+            else
+            {
+                cur_ = buffer_;
+                end_ = buffer_ + buffer_size_;
+            }
+        }
+
+        inline auto Arena::used() const -> std::size_t
+        {
+            return used_;
+        }
+
+        inline auto Arena::blocks() const -> std::size_t
+        {
+            std::size_t count = 0;
+            for (auto block = blocks_; block; block = block->next)
+                ++count;
+            return count;
+        }
+
         template<typename KeyType,typename DataType>
         struct OperatorEx;
 
         template<typename DataType,template<typename>class PtrType>
         struct Expression;
 
+        template<typename DataType>
+        struct Program;
+
         template<typename KeyType,typename DataType>
         struct ParserInfo
         {
+            using StackEntry = std::pair<std::shared_ptr<OperatorEx<KeyType,DataType>>,std::size_t>;
+
             bool value_class = true;
-            std::list<std::pair<std::shared_ptr<OperatorEx<KeyType,DataType>>,std::size_t>> stack;
-            Expression<DataType,std::shared_ptr> expression;
+            ArenaVector<StackEntry> stack;//was a std::list in 1.0; back/pop_back/emplace_back/empty still apply
+            Program<DataType> program;//replaces 1.0's linked `expression`: hooks call program.push_operator(op, size)
             std::size_t pos = 0;
             const std::basic_string<KeyType>& keys;
             ParserInfo(const std::basic_string<KeyType>& str) : keys(str) {}
+            // The operator stack lives in scratch, the program in storage (the heap when nullptr)
+            ParserInfo(const std::basic_string<KeyType>& str, Arena &scratch, Arena *storage = nullptr)
+                : stack(ArenaAllocator<StackEntry>(&scratch)), program(storage), keys(str) {}
+        };
+
+        // Marks an operator as one of the builtins so evaluators may run it natively
+        enum class OpCode : std::uint8_t
+        {
+            None,
+            Add,
+            Sub,
+            Mul,
+            Div,
+            Mod,
+            Pow,
+            Pos,
+            Neg,
+            Sin,
+            Cos,
+            Tan,
+            Asin,
+            Acos,
+            Atan,
+            Atan2,
+            Sinh,
+            Cosh,
+            Tanh,
+            Asinh,
+            Acosh,
+            Atanh,
+            Exp,
+            Exp2,
+            Ln,
+            Log,
+            Log10,
+            Log2,
+            Log1p,
+            Sqrt,
+            Cbrt,
+            Hypot,
+            Ceil,
+            Floor,
+            Round,
+            Trunc,
+            Abs,
+            Erf,
+            Erfc,
+            Tgamma,
+            Lgamma
         };
 
+        // Number of arguments the native form of a builtin takes, 0 for OpCode::None
+        constexpr auto builtin_arity(OpCode code) -> std::size_t
+        {
+            return code == OpCode::None ? 0
+                   : code == OpCode::Add || code == OpCode::Sub || code == OpCode::Mul || code == OpCode::Div ||
+                           code == OpCode::Mod || code == OpCode::Pow || code == OpCode::Atan2 ||
+                           code == OpCode::Log || code == OpCode::Hypot
+                       ? 2
+                       : 1;
+        }
+
+        // Whether the math builtins have native forms for DataType, which takes the <cmath>
+        // overloads: true for arithmetic types, specialize it for a custom type that has them.
+        // Other types only run + - * / and the signs natively; every other builtin keeps calling
+        // its Operator::function, as user operators do.
+        template <typename DataType>
+        struct native_math : std::is_arithmetic<DataType>
+        {
+        };
+
+        // Whether an instruction may carry code for DataType, see Instruction::code
+        template <typename DataType>
+        constexpr auto native_builtin(OpCode code) -> bool
+        {
+            return native_math<DataType>::value || code == OpCode::Add || code == OpCode::Sub ||
+                   code == OpCode::Mul || code == OpCode::Div || code == OpCode::Pos || code == OpCode::Neg;
+        }
+
+        template <typename DataType>
+        auto builtin_unary(OpCode code, const DataType &x, std::false_type) -> DataType
+        {
+            switch (code)
+            {
+            case OpCode::Pos: return x;
+            case OpCode::Neg: return -x;
+            default: throw std::invalid_argument("No native form of this builtin for the data type");
+            }
+        }
+
+        template <typename DataType>
+        auto builtin_binary(OpCode code, const DataType &x, const DataType &y, std::false_type) -> DataType
+        {
+            switch (code)
+            {
+            case OpCode::Add: return x + y;
+            case OpCode::Sub: return x - y;
+            case OpCode::Mul: return x * y;
+            case OpCode::Div: return x / y;
+            default: throw std::invalid_argument("No native form of this builtin for the data type");
+            }
+        }
+
+        template <typename DataType>
+        auto builtin_unary(OpCode code, const DataType &x, std::true_type) -> DataType
+        {
+            switch (code)
+            {
+            case OpCode::Pos: return +x;
+            case OpCode::Neg: return -x;
+            case OpCode::Sin: return std::sin(x);
+            case OpCode::Cos: return std::cos(x);
+            case OpCode::Tan: return std::tan(x);
+            case OpCode::Asin: return std::asin(x);
+            case OpCode::Acos: return std::acos(x);
+            case OpCode::Atan: return std::atan(x);
+            case OpCode::Sinh: return std::sinh(x);
+            case OpCode::Cosh: return std::cosh(x);
+            case OpCode::Tanh: return std::tanh(x);
+            case OpCode::Asinh: return std::asinh(x);
+            case OpCode::Acosh: return std::acosh(x);
+            case OpCode::Atanh: return std::atanh(x);
+            case OpCode::Exp: return std::exp(x);
+            case OpCode::Exp2: return std::exp2(x);
+            case OpCode::Ln: return std::log(x);
+            case OpCode::Log10: return std::log10(x);
+            case OpCode::Log2: return std::log2(x);
+            case OpCode::Log1p: return std::log1p(x);
+            case OpCode::Sqrt: return std::sqrt(x);
+            case OpCode::Cbrt: return std::cbrt(x);
+            case OpCode::Ceil: return std::ceil(x);
+            case OpCode::Floor: return std::floor(x);
+            case OpCode::Round: return std::round(x);
+            case OpCode::Trunc: return std::trunc(x);
+            case OpCode::Abs: return std::abs(x);
+            case OpCode::Erf: return std::erf(x);
+            case OpCode::Erfc: return std::erfc(x);
+            case OpCode::Tgamma: return std::tgamma(x);
+            case OpCode::Lgamma: return std::lgamma(x);
+            default: throw std::invalid_argument("Not a unary builtin");
+            }
+        }
+
+        template <typename DataType>
+        auto builtin_binary(OpCode code, const DataType &x, const DataType &y, std::true_type) -> DataType
+        {
+            switch (code)
+            {
+            case OpCode::Add: return x + y;
+            case OpCode::Sub: return x - y;
+            case OpCode::Mul: return x * y;
+            case OpCode::Div: return x / y;
+            case OpCode::Mod: return std::fmod(x, y);
+            case OpCode::Pow: return std::pow(x, y);
+            case OpCode::Atan2: return std::atan2(x, y);
+            case OpCode::Log: return std::log(y) / std::log(x);
+            case OpCode::Hypot: return std::hypot(x, y);
+            default: throw std::invalid_argument("Not a binary builtin");
+            }
+        }
+
+        template <typename DataType>
+        auto builtin_unary(OpCode code, const DataType &x) -> DataType
+        {
+            return builtin_unary(code, x, native_math<DataType>());
+        }
+
+        template <typename DataType>
+        auto builtin_binary(OpCode code, const DataType &x, const DataType &y) -> DataType
+        {
+            return builtin_binary(code, x, y, native_math<DataType>());
+        }
+
         template<typename DataType>
         struct Operator
         {
             std::function<DataType(ParamViewer<DataType>)> function;
+            std::function<DataType(ParamViewer<DataType>, std::size_t)> derivative;//partial by argument i, builtins have their own rules
+            OpCode code = OpCode::None;
+            bool pure = false;//same inputs always give the same result and no side effects
         };
 
+        // Profiling policy of the evaluation loops: each operator instruction opens a Scope with
+        // its instruction index and calls done() once it returned normally. This default does
+        // nothing and compiles away; core::Profiler in eval_profile.hpp records counters.
+        struct NoProfile
+        {
+            struct Scope
+            {
+                Scope(NoProfile &, std::size_t) {}
+                auto done() -> void {}
+            };
+        };
+
+        // Creates a standalone pure operator for one of the builtin codes; it reads its arguments
+        // through ParamViewer, so calls with too few arguments still throw
+        template <typename DataType>
+        auto builtin_operator(OpCode code) -> std::shared_ptr<Operator<DataType>>;
+
         enum class BreakType
         {
             RETURN,
@@ -234,11 +1139,216 @@ namespace ydog01
             std::function<BreakType(ParserInfo<KeyType, DataType>&)> extra_remaining;
         };
 
-        enum class TokenType:uint8_t
+        enum class TokenType:uint8_t
+        {
+            Constant,
+            Variale,
+            Operator,
+            Store,//copies the top of the stack into a temporary, programs only
+            Load,//pushes a temporary, programs only
+        };
+
+        // One step of a compiled program; operand indexes the pool selected by type
+        struct Instruction
+        {
+            TokenType type;
+            OpCode code;//set when the operator runs natively with exactly builtin_arity(code) arguments
+            std::uint32_t size;//arguments of an operator; 1 on a variable a user operator takes by reference
+            std::uint32_t operand;
+
+            Instruction() = default;
+            Instruction(TokenType type_, std::uint32_t size_, std::uint32_t operand_, OpCode code_ = OpCode::None)
+                : type(type_), code(code_), size(size_), operand(operand_)
+            {
+            }
+        };
+
+        template <typename DataType>
+        struct Workspace;
+
+        template <typename DataType>
+        struct Frame;
+
+        // Stable reference to the storage of a variable, see Evaluator::bind. It keeps the storage
+        // alive after remove_variable, and writing through it is a single store.
+        template <typename DataType>
+        class VariableHandle
+        {
+            std::shared_ptr<DataType> var_;
+
+        public:
+            VariableHandle() = default;
+            explicit VariableHandle(std::shared_ptr<DataType> var) : var_(std::move(var)) {}
+
+            auto get() const -> DataType *
+            {
+                return var_.get();
+            }
+
+            explicit operator bool() const
+            {
+                return var_ != nullptr;
+            }
+        };
+
+        // A contiguous input column bound to the variable slot it replaces
+        template <typename DataType>
+        struct Binding
+        {
+            const DataType *slot;
+            const DataType *data;
+            std::size_t size;
+        };
+
+        template <typename DataType>
+        struct Program
+        {
+            static constexpr std::size_t batch_tile = 256;
+
+            ArenaVector<Instruction> code;
+            ArenaVector<DataType> constants;
+            ArenaVector<std::shared_ptr<DataType>> variables;
+            ArenaVector<std::shared_ptr<Operator<DataType>>> operators;
+            std::size_t max_depth = 0;
+            std::size_t temporaries = 0;
+            std::size_t outputs = 1;//values the code leaves on the stack, one per expression
+
+            Program() = default;
+            // Keeps code and pools in arena (the heap when nullptr); copies go to the heap.
+            // Destroy the program before resetting the arena.
+            explicit Program(Arena *arena);
+
+            // Arena holding code and pools, nullptr for the heap
+            auto arena() const -> Arena *;
+
+            // Appends one instruction together with its pool entry
+            auto push_constant(DataType value) -> void;
+            auto push_variable(std::shared_ptr<DataType> var) -> void;
+            auto push_operator(std::shared_ptr<Operator<DataType>> op, std::size_t size) -> void;
+            auto push_store(std::size_t temp) -> void;
+            auto push_load(std::size_t temp) -> void;
+
+            // Checks the stack effect of the code, computes max_depth and merges repeated
+            // variables so each distinct slot appears once in variables
+            auto finalize() -> void;
+
+            // Index of var among variables, or npos when the program does not read it
+            auto slot_of(const DataType *var) const -> std::size_t;
+            auto slot_of(const VariableHandle<DataType> &var) const -> std::size_t;
+
+            // The first output; see values() for the others
+            auto value() const -> DataType;
+            // Evaluates without heap allocation once ws has been sized for this program
+            auto value(Workspace<DataType> &ws) const -> DataType;
+            // Reads variables from frame instead of the shared slots; the program itself is not
+            // touched, so threads can share it as long as each brings its own ws and frame
+            auto value(Workspace<DataType> &ws, const Frame<DataType> &frame) const -> DataType;
+            // Same as above, reporting every operator instruction to profile (a core::Profiler)
+            template <typename Profile, typename = typename Profile::Scope>
+            auto value(Workspace<DataType> &ws, Profile &profile) const -> DataType;
+            template <typename Profile, typename = typename Profile::Scope>
+            auto value(Workspace<DataType> &ws, const Frame<DataType> &frame, Profile &profile) const -> DataType;
+
+            // All outputs in one pass, out[i] for output i (Evaluator::parse of several expressions)
+            auto values() const -> std::vector<DataType>;
+            auto values(Workspace<DataType> &ws, DataType *out) const -> void;
+            auto values(Workspace<DataType> &ws, const Frame<DataType> &frame, DataType *out) const -> void;
+
+            // Evaluates rows [0, rows) into out, one tile of rows per instruction;
+            // variables without a binding keep their current scalar value. Output i of a
+            // multi-output program goes to out[i * rows, (i + 1) * rows).
+            auto value_batch(const std::vector<Binding<DataType>> &inputs, DataType *out, std::size_t rows,
+                             Workspace<DataType> &ws) const -> void;
+            auto value_batch(const std::vector<Binding<DataType>> &inputs, DataType *out, std::size_t rows) const
+                -> void;
+
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        private:
+            template <typename Source, typename Profile>
+            auto run(Workspace<DataType> &ws, Source source, Profile &profile) const -> DataType;
+
+            static auto read(const std::shared_ptr<DataType> *source, std::size_t slot) -> const DataType &
+            {
+                return *source[slot];
+            }
+            static auto read(const DataType *source, std::size_t slot) -> const DataType &
+            {
+                return source[slot];
+            }
+            // Shared slots are passed by reference; frame values stay copies on the stack
+            static auto refer(DataType *&ref, const std::shared_ptr<DataType> *source, std::size_t slot) -> void
+            {
+                ref = source[slot].get();
+            }
+            static auto refer(DataType *&, const DataType *, std::size_t) -> void
+            {
+            }
+
+            static auto run_tile(OpCode code, std::size_t size, DataType *out, const DataType *const *lanes,
+                                 const std::size_t *steps, std::size_t n) -> bool;
+        };
+
+        // Per-call variable values for Program::value(ws, frame), indexed by variable slot
+        template <typename DataType>
+        struct Frame
+        {
+            std::vector<DataType> values;
+
+            Frame() = default;
+            // Starts from the current values of the program's variables
+            explicit Frame(const Program<DataType> &program);
+
+            auto operator[](std::size_t slot) -> DataType &
+            {
+                return values[slot];
+            }
+            auto operator[](std::size_t slot) const -> const DataType &
+            {
+                return values[slot];
+            }
+        };
+
+        // Points refs back at their stack levels once a user operator, which may have been
+        // handed variables by reference, returns or throws
+        template <typename DataType>
+        struct RestoreRefs
         {
-            Constant,
-            Variale,
-            Operator,
+            DataType **refs;
+            DataType *stack;
+            std::size_t size;
+
+            RestoreRefs(DataType **refs_, DataType *stack_, std::size_t size_) : refs(refs_), stack(stack_), size(size_)
+            {
+            }
+            ~RestoreRefs()
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                    refs[i] = stack + i;
+            }
+        };
+
+        // Reusable evaluation state, grown to the largest program it has served
+        template <typename DataType>
+        struct Workspace
+        {
+            std::vector<DataType> stack;
+            std::vector<DataType *> refs;
+            std::vector<DataType> temps;
+
+            // Batch state: one tile per stack level, the lane each level reads and its stride
+            std::vector<DataType> tiles;
+            std::vector<const DataType *> lanes;
+            std::vector<std::size_t> steps;
+            std::vector<const DataType *> columns;
+            std::vector<DataType> temp_tiles;
+            std::vector<std::size_t> temp_steps;
+
+            Workspace() = default;
+            explicit Workspace(const Program<DataType> &program);
+
+            auto reserve(const Program<DataType> &program) -> void;
+            auto reserve_batch(const Program<DataType> &program) -> void;
         };
 
         template <typename T>
@@ -263,6 +1373,10 @@ namespace ydog01
             Expression(Expression &&other) noexcept = default;
             Expression &operator=(Expression &&other) noexcept = default;
 
+            template <typename U = PtrType<DataType>,
+                      typename std::enable_if<std::is_same<U, std::shared_ptr<DataType>>::value>::type * = nullptr>
+            explicit Expression(Program<DataType> &&program);
+
             template <template <typename> class OtherPtrType,
                       typename std::enable_if<
                           std::is_same<PtrType<DataType>, std::weak_ptr<DataType>>::value &&
@@ -293,7 +1407,14 @@ namespace ydog01
             template <typename U = PtrType<DataType>>
             auto value() const -> typename std::enable_if<is_weak_ptr<U>::value, DataType>::type;
 
+            // Reports every operator token to profile, indexed by token position (shared_ptr form only)
+            template <typename Profile, typename = typename Profile::Scope>
+            auto value(Profile &profile) const -> DataType;
+
         private:
+            template <typename Profile>
+            auto run(Profile &profile) const -> DataType;
+
             static auto convert_operators_shared_to_weak(
                 std::list<std::pair<std::shared_ptr<Operator<DataType>>, std::size_t>> &&other_ops)
                 -> std::list<std::pair<std::weak_ptr<Operator<DataType>>, std::size_t>>;
@@ -309,37 +1430,75 @@ namespace ydog01
                 -> std::list<std::shared_ptr<DataType>>;
         };
 
+        // Parser failure, with the offset into the expression text where it stopped
+        class ParseError : public std::runtime_error
+        {
+            std::size_t position_;
+
+        public:
+            ParseError(const std::string &message, std::size_t position)
+                : std::runtime_error(message), position_(position)
+            {
+            }
+
+            auto position() const -> std::size_t
+            {
+                return position_;
+            }
+        };
+
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
         struct ParserContext
         {
-            using NodeType = Node<MapType,KeyType,OperatorEx<KeyType,DataType>,OperatorEx<KeyType,DataType>,OperatorEx<KeyType,DataType>,DataType>;
+            using NodeType = Node<MapType,KeyType,OperatorEx<KeyType,DataType>,OperatorEx<KeyType,DataType>,OperatorEx<KeyType,DataType>,DataType,DataType>;
             static constexpr std::size_t prefix_pos = 0;
             static constexpr std::size_t infix_pos = 1;
             static constexpr std::size_t suffix_pos = 2;
             static constexpr std::size_t variable_pos = 3;
+            static constexpr std::size_t constant_pos = 4;//immutable named values, emitted as constants
 
             NodeType resource;
             std::function<bool(ParserInfo<KeyType, DataType>&)> skip;//if pos==size => return true
-            std::function<std::unique_ptr<DataType>(ParserInfo<KeyType, DataType>&)> constant_parser;//On failure, roll back the backtrack pointer and return nullptr
+            std::function<bool(ParserInfo<KeyType, DataType>&, DataType&)> constant_parser;//On failure, roll back the backtrack pointer and return false
+
+            // Adapts a constant parser written for 1.0, which returned the value boxed (nullptr on failure)
+            static auto boxed_constant_parser(std::function<std::unique_ptr<DataType>(ParserInfo<KeyType, DataType>&)> parser)
+                -> std::function<bool(ParserInfo<KeyType, DataType>&, DataType&)>;
             
+            // Parsing only reads the context, so threads may parse concurrently while nobody
+            // changes it. Syntax errors are thrown as ParseError.
             template<template<typename>class PtrType>
-            auto parse(const std::basic_string<KeyType> &keys ) -> Expression<DataType,PtrType>;
+            auto parse(const std::basic_string<KeyType> &keys ) const -> Expression<DataType,PtrType>;
+
+            // Parses straight into the flat program form
+            auto compile(const std::basic_string<KeyType> &keys) const -> Program<DataType>;
+            // Same, with all parser state and the program in arena: compiling many formulas then
+            // costs a few block allocations, and one arena.reset() frees them after the programs die
+            auto compile(const std::basic_string<KeyType> &keys, Arena &arena) const -> Program<DataType>;
+
+            // Parser state of one call starts in a stack buffer of this size
+            static constexpr std::size_t scratch_bytes = 2048;
         private:
-            auto call_skip(ParserInfo<KeyType, DataType>& info)->bool;
-            auto call_constant_parser(ParserInfo<KeyType, DataType>& info)->bool;
+            auto run(ParserInfo<KeyType, DataType> &info) const -> void;
 
-            template<std::size_t I,std::size_t II>
-            auto parse_name(ParserInfo<KeyType, DataType>& info) -> void;
+            auto call_skip(ParserInfo<KeyType, DataType>& info) const->bool;
+            auto call_constant_parser(ParserInfo<KeyType, DataType>& info) const->bool;
+
+            template<std::size_t I,std::size_t II,std::size_t III = II>
+            auto parse_name(ParserInfo<KeyType, DataType>& info) const -> void;
+            // Programs share the registered variables and operators; the parser never writes them
+            template<std::size_t I>
+            static auto insert(ParserInfo<KeyType, DataType>& info,const NodeType* target) -> typename std::enable_if<I == variable_pos>::type;
             template<std::size_t I>
-            auto insert(ParserInfo<KeyType, DataType>& info,NodeType* target) -> typename std::enable_if<I == variable_pos>::type;
+            static auto insert(ParserInfo<KeyType, DataType>& info,const NodeType* target) -> typename std::enable_if<I == constant_pos>::type;
             template<std::size_t I>
-            auto insert(ParserInfo<KeyType, DataType>& info,NodeType* target) -> typename std::enable_if<I != variable_pos>::type;
+            static auto insert(ParserInfo<KeyType, DataType>& info,const NodeType* target) -> typename std::enable_if<I != variable_pos && I != constant_pos>::type;
 
             static auto insert_operator(ParserInfo<KeyType, DataType>& info,std::shared_ptr<OperatorEx<KeyType, DataType>> op) -> void;
-            static auto insert_constant(ParserInfo<KeyType, DataType>& info,std::unique_ptr<DataType>&& data) -> void;
+            static auto insert_constant(ParserInfo<KeyType, DataType>& info,DataType data) -> void;
             static auto insert_variable(ParserInfo<KeyType, DataType>& info,std::shared_ptr<DataType> var) -> void;
 
-            auto flush_operator_stack(ParserInfo<KeyType, DataType> &info) -> void;
+            static auto flush_operator_stack(ParserInfo<KeyType, DataType> &info) -> void;
         };
 
         template <template <typename, typename> class MapType, typename KeyType, typename... DataType>
@@ -486,7 +1645,7 @@ namespace ydog01
         auto Node<MapType, KeyType, DataType...>::search(const Keys &...keys) const -> const Node *
         {
             static_assert(sizeof...(Keys) > 0, "At least one key required");
-            const auto current(this);
+            auto current(this);
             std::initializer_list<int>{(current = current ? current->next(keys) : current, 0)...};
             return current;
         }
@@ -509,7 +1668,7 @@ namespace ydog01
         template <typename Container>
         auto Node<MapType, KeyType, DataType...>::search(const Container &keys) const -> decltype(std::begin(keys), std::end(keys), static_cast<const Node*>(nullptr))
         {
-            const auto current(this);
+            auto current(this);
             for (const auto &key : keys)
             {
                 current = current->next(key);
@@ -653,17 +1812,558 @@ namespace ydog01
             child.clear();
         }
 
+        template <typename DataType>
+        auto Program<DataType>::push_constant(DataType value) -> void
+        {
+            code.push_back({TokenType::Constant, 0, static_cast<std::uint32_t>(constants.size())});
+            constants.emplace_back(std::move(value));
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::push_variable(std::shared_ptr<DataType> var) -> void
+        {
+            code.push_back({TokenType::Variale, 0, static_cast<std::uint32_t>(variables.size())});
+            variables.emplace_back(std::move(var));
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::push_operator(std::shared_ptr<Operator<DataType>> op, std::size_t size) -> void
+        {
+            code.push_back({TokenType::Operator, static_cast<std::uint32_t>(size),
+                            static_cast<std::uint32_t>(operators.size()),
+                            builtin_arity(op->code) == size && native_builtin<DataType>(op->code) ? op->code : OpCode::None});
+            operators.emplace_back(std::move(op));
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::push_store(std::size_t temp) -> void
+        {
+            code.push_back({TokenType::Store, 0, static_cast<std::uint32_t>(temp)});
+            if (temp >= temporaries)
+                temporaries = temp + 1;
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::push_load(std::size_t temp) -> void
+        {
+            code.push_back({TokenType::Load, 0, static_cast<std::uint32_t>(temp)});
+            if (temp >= temporaries)
+                temporaries = temp + 1;
+        }
+
+        template <typename DataType>
+        Program<DataType>::Program(Arena *arena)
+            : code(ArenaAllocator<Instruction>(arena)), constants(ArenaAllocator<DataType>(arena)),
+              variables(ArenaAllocator<std::shared_ptr<DataType>>(arena)),
+              operators(ArenaAllocator<std::shared_ptr<Operator<DataType>>>(arena))
+        {
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::arena() const -> Arena *
+        {
+            return code.get_allocator().arena();
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::finalize() -> void
+        {
+            char buffer[1024];
+            Arena scratch(buffer, sizeof(buffer));
+            // Instruction that pushed each stack level, so variables handed straight to a user
+            // operator can be marked; run() passes those by reference, as Expression does
+            std::vector<std::size_t, ArenaAllocator<std::size_t>> pushed{ArenaAllocator<std::size_t>(&scratch)};
+            std::size_t depth = 0;
+            max_depth = 0;
+            for (std::size_t i = 0; i < code.size(); ++i)
+            {
+                auto &ins = code[i];
+                if (ins.type == TokenType::Operator)
+                {
+                    if (ins.size > depth)
+                        throw std::out_of_range("Operator require-size out of range");
+                    if (!operators[ins.operand]->function)
+                        throw std::runtime_error("Wrong Operator");
+                    depth -= ins.size;
+                    if (ins.code == OpCode::None)
+                        for (std::size_t j = depth; j < depth + ins.size; ++j)
+                            if (code[pushed[j]].type == TokenType::Variale)
+                                code[pushed[j]].size = 1;
+                }
+                else if (ins.type == TokenType::Store)
+                {
+                    if (!depth)
+                        throw std::out_of_range("Store on an empty stack");
+                    continue;
+                }
+                else if (ins.type == TokenType::Variale)
+                    ins.size = 0;
+                if (pushed.size() <= depth)
+                    pushed.resize(depth + 1);
+                pushed[depth] = i;
+                if (++depth > max_depth)
+                    max_depth = depth;
+            }
+            if (depth != outputs)
+                throw std::logic_error(outputs == 1 ? "Expression evaluation failed: stack size not 1"
+                                                    : "Expression evaluation failed: stack size not the output count");
+
+            using Slot = std::pair<const DataType *const, std::uint32_t>;
+            std::unordered_map<const DataType *, std::uint32_t, std::hash<const DataType *>,
+                               std::equal_to<const DataType *>, ArenaAllocator<Slot>>
+                slots(variables.size(), std::hash<const DataType *>(), std::equal_to<const DataType *>(),
+                      ArenaAllocator<Slot>(&scratch));
+            decltype(variables) distinct(variables.get_allocator());
+            for (auto &ins : code)
+                if (ins.type == TokenType::Variale)
+                {
+                    auto slot = slots.emplace(variables[ins.operand].get(), static_cast<std::uint32_t>(distinct.size()));
+                    if (slot.second)
+                        distinct.push_back(variables[ins.operand]);
+                    ins.operand = slot.first->second;
+                }
+            variables = std::move(distinct);
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::slot_of(const DataType *var) const -> std::size_t
+        {
+            for (std::size_t i = 0; i < variables.size(); ++i)
+                if (variables[i].get() == var)
+                    return i;
+            return npos;
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::slot_of(const VariableHandle<DataType> &var) const -> std::size_t
+        {
+            return slot_of(var.get());
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::value() const -> DataType
+        {
+            Workspace<DataType> ws(*this);
+            return value(ws);
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::value(Workspace<DataType> &ws) const -> DataType
+        {
+            NoProfile none;
+            return run(ws, variables.data(), none);
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::value(Workspace<DataType> &ws, const Frame<DataType> &frame) const -> DataType
+        {
+            NoProfile none;
+            return value(ws, frame, none);
+        }
+
+        template <typename DataType>
+        template <typename Profile, typename>
+        auto Program<DataType>::value(Workspace<DataType> &ws, Profile &profile) const -> DataType
+        {
+            return run(ws, variables.data(), profile);
+        }
+
+        template <typename DataType>
+        template <typename Profile, typename>
+        auto Program<DataType>::value(Workspace<DataType> &ws, const Frame<DataType> &frame, Profile &profile) const
+            -> DataType
+        {
+            if (frame.values.size() < variables.size())
+                throw std::out_of_range("Frame has fewer values than the program has variables");
+            return run(ws, frame.values.data(), profile);
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::values() const -> std::vector<DataType>
+        {
+            Workspace<DataType> ws(*this);
+            std::vector<DataType> out(outputs);
+            values(ws, out.data());
+            return out;
+        }
+
+        // The outputs are what run() leaves at the bottom of the stack
+        template <typename DataType>
+        auto Program<DataType>::values(Workspace<DataType> &ws, DataType *out) const -> void
+        {
+            out[0] = value(ws);
+            std::copy(ws.stack.begin() + 1, ws.stack.begin() + outputs, out + 1);
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::values(Workspace<DataType> &ws, const Frame<DataType> &frame, DataType *out) const
+            -> void
+        {
+            out[0] = value(ws, frame);
+            std::copy(ws.stack.begin() + 1, ws.stack.begin() + outputs, out + 1);
+        }
+
+        template <typename DataType>
+        template <typename Source, typename Profile>
+        auto Program<DataType>::run(Workspace<DataType> &ws, Source source, Profile &profile) const -> DataType
+        {
+            ws.reserve(*this);
+            auto stack = ws.stack.data();
+            auto refs = ws.refs.data();
+            std::size_t top = 0;
+            for (const auto &ins : code)
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                    stack[top++] = constants[ins.operand];
+                    break;
+                case TokenType::Variale:
+                    stack[top] = read(source, ins.operand);
+                    if (ins.size)
+                        refer(refs[top], source, ins.operand);
+                    ++top;
+                    break;
+                case TokenType::Operator:
+                {
+                    typename Profile::Scope scope(profile, static_cast<std::size_t>(&ins - code.data()));
+                    switch (ins.code)
+                    {
+                    case OpCode::None:
+                    {
+                        top -= ins.size;
+                        const RestoreRefs<DataType> restore(refs + top, stack + top, ins.size);
+                        stack[top] = operators[ins.operand]->function(ParamViewer<DataType>(refs + top, ins.size));
+                        ++top;
+                        break;
+                    }
+                    case OpCode::Add:
+                        --top;
+                        stack[top - 1] = stack[top - 1] + stack[top];
+                        break;
+                    case OpCode::Sub:
+                        --top;
+                        stack[top - 1] = stack[top - 1] - stack[top];
+                        break;
+                    case OpCode::Mul:
+                        --top;
+                        stack[top - 1] = stack[top - 1] * stack[top];
+                        break;
+                    case OpCode::Div:
+                        --top;
+                        stack[top - 1] = stack[top - 1] / stack[top];
+                        break;
+                    case OpCode::Neg:
+                        stack[top - 1] = -stack[top - 1];
+                        break;
+                    default:
+                        if (ins.size == 2)
+                        {
+                            --top;
+                            stack[top - 1] = builtin_binary(ins.code, stack[top - 1], stack[top]);
+                        }
+                        else
+                            stack[top - 1] = builtin_unary(ins.code, stack[top - 1]);
+                        break;
+                    }
+                    scope.done();
+                    break;
+                }
+                case TokenType::Store:
+                    ws.temps[ins.operand] = stack[top - 1];
+                    break;
+                case TokenType::Load:
+                    stack[top++] = ws.temps[ins.operand];
+                    break;
+                }
+            return stack[0];
+        }
+
+        template <typename DataType>
+        constexpr std::size_t Program<DataType>::batch_tile;
+
+        template <typename DataType>
+        auto builtin_operator(OpCode code) -> std::shared_ptr<Operator<DataType>>
+        {
+            auto op = std::make_shared<Operator<DataType>>();
+            op->code = code;
+            op->pure = true;
+            switch (builtin_arity(code))
+            {
+            case 1:
+                op->function = [code](ParamViewer<DataType> a) -> DataType { return builtin_unary(code, a[0]); };
+                break;
+            case 2:
+                op->function = [code](ParamViewer<DataType> a) -> DataType
+                { return builtin_binary(code, a[0], a[1]); };
+                break;
+            default:
+                throw std::invalid_argument("Not a builtin operator");
+            }
+            return op;
+        }
+
+        template <typename DataType, typename Function>
+        auto batch_binary(DataType *out, const DataType *a, std::size_t sa, const DataType *b, std::size_t sb,
+                          std::size_t n, Function fn) -> void
+        {
+            if (sa && sb)
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = fn(a[i], b[i]);
+            else if (sa)
+            {
+                const DataType y = *b;
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = fn(a[i], y);
+            }
+            else if (sb)
+            {
+                const DataType x = *a;
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = fn(x, b[i]);
+            }
+            else
+            {
+                const DataType v = fn(*a, *b);
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = v;
+            }
+        }
+
+        template <typename DataType, typename Function>
+        auto batch_unary(DataType *out, const DataType *a, std::size_t sa, std::size_t n, Function fn) -> void
+        {
+            if (sa)
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = fn(a[i]);
+            else
+            {
+                const DataType v = fn(*a);
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = v;
+            }
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::run_tile(OpCode code, std::size_t size, DataType *out, const DataType *const *lanes,
+                                         const std::size_t *steps, std::size_t n) -> bool
+        {
+            if (size == 2)
+                switch (code)
+                {
+                case OpCode::Add:
+                    batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                                 [](DataType x, DataType y) -> DataType { return x + y; });
+                    return true;
+                case OpCode::Sub:
+                    batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                                 [](DataType x, DataType y) -> DataType { return x - y; });
+                    return true;
+                case OpCode::Mul:
+                    batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                                 [](DataType x, DataType y) -> DataType { return x * y; });
+                    return true;
+                case OpCode::Div:
+                    batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                                 [](DataType x, DataType y) -> DataType { return x / y; });
+                    return true;
+                case OpCode::Mod:
+                    batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                                 [](DataType x, DataType y) -> DataType { return builtin_binary(OpCode::Mod, x, y); });
+                    return true;
+                case OpCode::Pow:
+                    batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                                 [](DataType x, DataType y) -> DataType { return builtin_binary(OpCode::Pow, x, y); });
+                    return true;
+                default:
+                    break;
+                }
+            if (size == 1)
+                switch (code)
+                {
+                case OpCode::Pos:
+                    batch_unary(out, lanes[0], steps[0], n, [](DataType x) -> DataType { return x; });
+                    return true;
+                case OpCode::Neg:
+                    batch_unary(out, lanes[0], steps[0], n, [](DataType x) -> DataType { return -x; });
+                    return true;
+                default:
+                    break;
+                }
+            if (code == OpCode::None)
+                return false;
+            if (size == 2)
+                batch_binary(out, lanes[0], steps[0], lanes[1], steps[1], n,
+                             [code](DataType x, DataType y) -> DataType { return builtin_binary(code, x, y); });
+            else
+                batch_unary(out, lanes[0], steps[0], n,
+                            [code](DataType x) -> DataType { return builtin_unary(code, x); });
+            return true;
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::value_batch(const std::vector<Binding<DataType>> &inputs, DataType *out,
+                                            std::size_t rows) const -> void
+        {
+            Workspace<DataType> ws;
+            value_batch(inputs, out, rows, ws);
+        }
+
+        template <typename DataType>
+        auto Program<DataType>::value_batch(const std::vector<Binding<DataType>> &inputs, DataType *out,
+                                            std::size_t rows, Workspace<DataType> &ws) const -> void
+        {
+            ws.reserve_batch(*this);
+            for (std::size_t i = 0; i < variables.size(); ++i)
+            {
+                ws.columns[i] = nullptr;
+                for (const auto &input : inputs)
+                    if (input.slot == variables[i].get())
+                    {
+                        if (input.size < rows)
+                            throw std::out_of_range("Input column shorter than row count");
+                        ws.columns[i] = input.data;
+                    }
+            }
+
+            auto stack = ws.stack.data();
+            auto refs = ws.refs.data();
+            auto lanes = ws.lanes.data();
+            auto steps = ws.steps.data();
+            for (std::size_t row = 0; row < rows; row += batch_tile)
+            {
+                const std::size_t n = rows - row < batch_tile ? rows - row : batch_tile;
+                std::size_t top = 0;
+                for (const auto &ins : code)
+                    switch (ins.type)
+                    {
+                    case TokenType::Constant:
+                        lanes[top] = &constants[ins.operand];
+                        steps[top++] = 0;
+                        break;
+                    case TokenType::Variale:
+                        if (ws.columns[ins.operand])
+                        {
+                            lanes[top] = ws.columns[ins.operand] + row;
+                            steps[top++] = 1;
+                        }
+                        else
+                        {
+                            lanes[top] = variables[ins.operand].get();
+                            steps[top++] = 0;
+                        }
+                        break;
+                    case TokenType::Operator:
+                    {
+                        top -= ins.size;
+                        auto tile = &ws.tiles[top * batch_tile];
+                        const auto &op = *operators[ins.operand];
+                        if (!run_tile(ins.code, ins.size, tile, lanes + top, steps + top, n))
+                            for (std::size_t i = 0; i < n; ++i)
+                            {
+                                for (std::size_t j = top; j < top + ins.size; ++j)
+                                    stack[j] = lanes[j][i * steps[j]];
+                                tile[i] = op.function(ParamViewer<DataType>(refs + top, ins.size));
+                            }
+                        lanes[top] = tile;
+                        steps[top++] = 1;
+                        break;
+                    }
+                    case TokenType::Store:
+                    {
+                        auto saved = &ws.temp_tiles[ins.operand * batch_tile];
+                        const std::size_t count = steps[top - 1] ? n : 1;
+                        for (std::size_t i = 0; i < count; ++i)
+                            saved[i] = lanes[top - 1][i];
+                        ws.temp_steps[ins.operand] = steps[top - 1];
+                        break;
+                    }
+                    case TokenType::Load:
+                        lanes[top] = &ws.temp_tiles[ins.operand * batch_tile];
+                        steps[top++] = ws.temp_steps[ins.operand];
+                        break;
+                    }
+                for (std::size_t k = 0; k < outputs; ++k)
+                    for (std::size_t i = 0; i < n; ++i)
+                        out[k * rows + row + i] = lanes[k][i * steps[k]];
+            }
+        }
+
+        template <typename DataType>
+        Frame<DataType>::Frame(const Program<DataType> &program)
+        {
+            values.reserve(program.variables.size());
+            for (const auto &var : program.variables)
+                values.push_back(*var);
+        }
+
+        template <typename DataType>
+        Workspace<DataType>::Workspace(const Program<DataType> &program)
+        {
+            reserve(program);
+        }
+
+        template <typename DataType>
+        auto Workspace<DataType>::reserve(const Program<DataType> &program) -> void
+        {
+            if (temps.size() < program.temporaries)
+                temps.resize(program.temporaries);
+            if (stack.size() >= program.max_depth)
+                return;
+            stack.resize(program.max_depth);
+            refs.resize(program.max_depth);
+            for (std::size_t i = 0; i < stack.size(); ++i)
+                refs[i] = &stack[i];
+        }
+
+        template <typename DataType>
+        auto Workspace<DataType>::reserve_batch(const Program<DataType> &program) -> void
+        {
+            reserve(program);
+            if (lanes.size() < program.max_depth)
+            {
+                tiles.resize(program.max_depth * Program<DataType>::batch_tile);
+                lanes.resize(program.max_depth);
+                steps.resize(program.max_depth);
+            }
+            if (columns.size() < program.variables.size())
+                columns.resize(program.variables.size());
+            if (temp_steps.size() < program.temporaries)
+            {
+                temp_tiles.resize(program.temporaries * Program<DataType>::batch_tile);
+                temp_steps.resize(program.temporaries);
+            }
+        }
+
         template <typename DataType, template <typename> class PtrType>
         template <typename U>
         auto Expression<DataType, PtrType>::value() const ->
             typename std::enable_if<!is_weak_ptr<U>::value, DataType>::type
+        {
+            NoProfile none;
+            return run(none);
+        }
+
+        template <typename DataType, template <typename> class PtrType>
+        template <typename Profile, typename>
+        auto Expression<DataType, PtrType>::value(Profile &profile) const -> DataType
+        {
+            static_assert(!is_weak_ptr<PtrType<DataType>>::value, "Lock a weak Expression into a shared one to profile it");
+            return run(profile);
+        }
+
+        template <typename DataType, template <typename> class PtrType>
+        template <typename Profile>
+        auto Expression<DataType, PtrType>::run(Profile &profile) const -> DataType
         {
             std::list<std::unique_ptr<DataType>> cache;
             std::vector<DataType*> stack;
             auto operator_ptr = operators.begin();
             auto variable_ptr = variables.begin();
             auto constant_ptr = constants.begin();
+            std::size_t position = 0;
             for(auto token:index)
+            {
+                ++position;
                 switch (token)
                 {
                 case TokenType::Constant:
@@ -685,12 +2385,19 @@ namespace ydog01
                         throw std::out_of_range("Operator require-size out of range");
                     if (!((*operator_ptr).first->function))
                         throw std::runtime_error("Wrong Operator");
-                    cache.emplace_back(make_unique<DataType>((*(*operator_ptr).first).function(ParamViewer<DataType>((const_cast<DataType**>(&*stack.end())-(*operator_ptr).second),(*operator_ptr).second))));
+                    {
+                        typename Profile::Scope scope(profile, position - 1);
+                        cache.emplace_back(make_unique<DataType>((*(*operator_ptr).first).function(ParamViewer<DataType>((const_cast<DataType**>(&*stack.end())-(*operator_ptr).second),(*operator_ptr).second))));
+                        scope.done();
+                    }
                     stack.resize(stack.size()-(*operator_ptr).second);
                     stack.emplace_back(cache.back().get());
                     operator_ptr++;
                     break;
+                default:
+                    throw std::logic_error("Unexpected token in expression");
                 }
+            }
             if (stack.size() != 1)
                 throw std::logic_error("Expression evaluation failed: stack size not 1");
             return DataType(std::move(*stack.back()));
@@ -726,6 +2433,30 @@ namespace ydog01
             return result;
         }
 
+        template <typename DataType, template <typename> class PtrType>
+        template <typename U, typename std::enable_if<std::is_same<U, std::shared_ptr<DataType>>::value>::type *>
+        Expression<DataType, PtrType>::Expression(Program<DataType> &&program)
+        {
+            for (const auto &ins : program.code)
+            {
+                index.emplace_back(ins.type);
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                    constants.emplace_back(make_unique<DataType>(program.constants[ins.operand]));
+                    break;
+                case TokenType::Variale:
+                    variables.emplace_back(program.variables[ins.operand]);
+                    break;
+                case TokenType::Operator:
+                    operators.emplace_back(std::move(program.operators[ins.operand]), ins.size);
+                    break;
+                default:
+                    throw std::logic_error("Temporaries cannot be expressed in the list form");
+                }
+            }
+        }
+
         template <typename DataType, template <typename> class PtrType>
         template <
             template <typename> class OtherPtrType,
@@ -838,45 +2569,103 @@ namespace ydog01
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
         template <template <typename> class PtrType>
-        auto ParserContext<MapType, KeyType, DataType>::parse(const std::basic_string<KeyType> &keys)-> Expression<DataType, PtrType>
+        auto ParserContext<MapType, KeyType, DataType>::parse(const std::basic_string<KeyType> &keys) const -> Expression<DataType, PtrType>
         {
             static_assert(std::is_same<PtrType<DataType>, std::shared_ptr<DataType>>::value ||
                               std::is_same<PtrType<DataType>, std::weak_ptr<DataType>>::value,
                           "PtrType must be std::shared_ptr or std::weak_ptr");
             
-            ParserInfo<KeyType,DataType> info(keys);
+            char buffer[scratch_bytes];
+            Arena scratch(buffer, sizeof(buffer));
+            ParserInfo<KeyType, DataType> info(keys, scratch, &scratch);
+            run(info);
+            return Expression<DataType, PtrType>(Expression<DataType, std::shared_ptr>(std::move(info.program)));
+        }
 
-            while(info.pos < keys.size())
-            {
-                if(call_skip(info))
-                    break;
+        template <template <typename, typename> class MapType, typename KeyType, typename DataType>
+        auto ParserContext<MapType, KeyType, DataType>::compile(const std::basic_string<KeyType> &keys) const
+            -> Program<DataType>
+        {
+            char buffer[scratch_bytes];
+            Arena scratch(buffer, sizeof(buffer));
+            ParserInfo<KeyType, DataType> info(keys, scratch);
+            run(info);
+            info.program.finalize();
+            return std::move(info.program);
+        }
+
+        template <template <typename, typename> class MapType, typename KeyType, typename DataType>
+        auto ParserContext<MapType, KeyType, DataType>::compile(const std::basic_string<KeyType> &keys, Arena &arena) const
+            -> Program<DataType>
+        {
+            ParserInfo<KeyType, DataType> info(keys, arena, &arena);
+            run(info);
+            info.program.finalize();
+            return std::move(info.program);
+        }
 
-                if(info.value_class)
+        template <template <typename, typename> class MapType, typename KeyType, typename DataType>
+        auto ParserContext<MapType, KeyType, DataType>::run(ParserInfo<KeyType, DataType> &info) const -> void
+        {
+            const auto &keys = info.keys;
+            std::size_t token = 0;//start of the token being parsed, where errors are reported
+            try
+            {
+                while(info.pos < keys.size())
                 {
-                    if(call_constant_parser(info))
-                        continue;
-                    parse_name<prefix_pos, variable_pos>(info);
+                    if(call_skip(info))
+                        break;
+                    token = info.pos;
+
+                    if(info.value_class)
+                    {
+                        if(call_constant_parser(info))
+                            continue;
+                        parse_name<prefix_pos, variable_pos, constant_pos>(info);
+                    }
+                    else
+                        parse_name<infix_pos, suffix_pos>(info);
                 }
-                else
-                    parse_name<infix_pos, suffix_pos>(info);
+                token = keys.size();
+                flush_operator_stack(info);
+            }
+            catch (const ParseError &)
+            {
+                throw;
+            }
+            catch (const std::runtime_error &e)
+            {
+                throw ParseError(e.what(), token);
             }
-            flush_operator_stack(info);
-            return Expression<DataType, PtrType>(std::move(info.expression));
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
-        auto ParserContext<MapType, KeyType, DataType>::call_skip(ParserInfo<KeyType, DataType>& info) -> bool
+        auto ParserContext<MapType, KeyType, DataType>::call_skip(ParserInfo<KeyType, DataType>& info) const -> bool
         {
             return skip&&skip(info);
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
-        auto ParserContext<MapType, KeyType, DataType>::call_constant_parser(ParserInfo<KeyType, DataType>& info) -> bool
+        auto ParserContext<MapType, KeyType, DataType>::boxed_constant_parser(std::function<std::unique_ptr<DataType>(ParserInfo<KeyType, DataType>&)> parser)
+            -> std::function<bool(ParserInfo<KeyType, DataType>&, DataType&)>
+        {
+            return [parser](ParserInfo<KeyType, DataType>& info, DataType& value) -> bool
+            {
+                auto boxed = parser(info);
+                if (!boxed)
+                    return false;
+                value = std::move(*boxed);
+                return true;
+            };
+        }
+
+        template <template <typename, typename> class MapType, typename KeyType, typename DataType>
+        auto ParserContext<MapType, KeyType, DataType>::call_constant_parser(ParserInfo<KeyType, DataType>& info) const -> bool
         {
             if (constant_parser)
             {
-                auto constant = constant_parser(info);
-                if (constant)
+                DataType constant{};
+                if (constant_parser(info, constant))
                 {
                     insert_constant(info, std::move(constant));
                     return true;
@@ -888,8 +2677,7 @@ namespace ydog01
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
         auto ParserContext<MapType, KeyType, DataType>::insert_variable(ParserInfo<KeyType, DataType>& info,std::shared_ptr<DataType> var) -> void
         {
-            info.expression.variables.emplace_back(var);
-            info.expression.index.emplace_back(TokenType::Variale);
+            info.program.push_variable(std::move(var));
             info.value_class = false;
         }
 
@@ -917,8 +2705,7 @@ namespace ydog01
                 }
                 if (top.first->precedence < op->precedence ||(op->assoc == Associativity::Right && top.first->precedence == op->precedence))
                     break;
-                info.expression.index.emplace_back(TokenType::Operator);
-                info.expression.operators.emplace_back(top);
+                info.program.push_operator(top.first, top.second);
                 info.stack.pop_back();
             }
             info.stack.emplace_back(std::make_pair(op,op->default_param_size));
@@ -927,23 +2714,22 @@ namespace ydog01
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
-        auto ParserContext<MapType, KeyType, DataType>::insert_constant(ParserInfo<KeyType, DataType>& info,std::unique_ptr<DataType>&& data) -> void
+        auto ParserContext<MapType, KeyType, DataType>::insert_constant(ParserInfo<KeyType, DataType>& info,DataType data) -> void
         {
-            info.expression.index.emplace_back(TokenType::Constant);
-            info.expression.constants.emplace_back(std::move(data));
+            info.program.push_constant(std::move(data));
             info.value_class = false;
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
-        template <std::size_t I, std::size_t II>
-        auto ParserContext<MapType, KeyType, DataType>::parse_name(ParserInfo<KeyType, DataType> &info) -> void
+        template <std::size_t I, std::size_t II, std::size_t III>
+        auto ParserContext<MapType, KeyType, DataType>::parse_name(ParserInfo<KeyType, DataType> &info) const -> void
         {
-            std::size_t last_pos;
+            std::size_t last_pos = 0;
             auto nex(resource.next(info.keys[info.pos]));
-            NodeType *last_one(nullptr);
+            const NodeType *last_one(nullptr);
             while (nex)
             {
-                if (nex->template has_data<I>()||nex->template has_data<II>())
+                if (nex->template has_data<I>()||nex->template has_data<II>()||nex->template has_data<III>())
                 {
                     last_one = nex;
                     last_pos = info.pos;
@@ -957,24 +2743,33 @@ namespace ydog01
 
             if (last_one->template has_data<I>())
                 insert<I>(info,last_one);
-            else
+            else if (last_one->template has_data<II>())
                 insert<II>(info,last_one);
+            else
+                insert<III>(info,last_one);
 
             info.pos = last_pos + 1;
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
         template <std::size_t I>
-        auto ParserContext<MapType, KeyType, DataType>::insert(ParserInfo<KeyType, DataType> &info,NodeType* target) -> typename std::enable_if<I == variable_pos>::type
+        auto ParserContext<MapType, KeyType, DataType>::insert(ParserInfo<KeyType, DataType> &info,const NodeType* target) -> typename std::enable_if<I == variable_pos>::type
+        {
+            insert_variable(info, std::const_pointer_cast<DataType>(target->template get_data<I>()));
+        }
+
+        template <template <typename, typename> class MapType, typename KeyType, typename DataType>
+        template <std::size_t I>
+        auto ParserContext<MapType, KeyType, DataType>::insert(ParserInfo<KeyType, DataType> &info,const NodeType* target) -> typename std::enable_if<I == constant_pos>::type
         {
-            insert_variable(info, target->template get_data<I>());
+            insert_constant(info, *target->template get_data<I>());
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
         template <std::size_t I>
-        auto ParserContext<MapType, KeyType, DataType>::insert(ParserInfo<KeyType, DataType> &info,NodeType* target) -> typename std::enable_if<I != variable_pos>::type
+        auto ParserContext<MapType, KeyType, DataType>::insert(ParserInfo<KeyType, DataType> &info,const NodeType* target) -> typename std::enable_if<I != variable_pos && I != constant_pos>::type
         {
-            insert_operator(info, target->template get_data<I>());
+            insert_operator(info, std::const_pointer_cast<OperatorEx<KeyType, DataType>>(target->template get_data<I>()));
         }
 
         template <template <typename, typename> class MapType, typename KeyType, typename DataType>
@@ -995,8 +2790,7 @@ namespace ydog01
                     else if(flag==BreakType::CONTINUE)
                         continue;
                 }
-                info.expression.index.emplace_back(TokenType::Operator);
-                info.expression.operators.emplace_back(top);
+                info.program.push_operator(top.first, top.second);
                 info.stack.pop_back();
             }
         }
@@ -0,0 +1,330 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_IMAGE_HPP
+#define EVAL_IMAGE_HPP
+
+#include "eval_core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EVAL_IMAGE_MMAP 1
+#else
+#define EVAL_IMAGE_MMAP 0
+#endif
+
+// Binary images of compiled programs (Evaluator::save_image / load_image). An image is
+// written in native byte order and keeps every section 16-byte aligned, so it can be used
+// straight from a mapped file:
+//
+//   ImageHeader
+//   names:     ImageName + name characters, padded to 8 bytes, per entry
+//   directory: one uint64 offset per program
+//   programs:  ImageProgram, Instruction[code], DataType[constants] (16-byte aligned),
+//              uint32 name index per variable slot, then per operator slot
+//
+// Programs refer to variables and operators only through the name table, which the loader
+// resolves once per image; the header carries Evaluator::fingerprint() of the evaluator
+// that wrote it.
+
+namespace ydog01
+{
+    namespace core
+    {
+        enum class SymbolKind : std::uint8_t
+        {
+            Variable,
+            Prefix,
+            Infix,
+            Suffix,
+            Builtin // standalone builtin made by the optimizer, stored by its OpCode
+        };
+
+        struct ImageHeader
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t byte_order; // 0x01020304 as the writer stored it
+            std::uint16_t key_size;
+            std::uint16_t data_size;
+            std::uint64_t fingerprint;
+            std::uint32_t names;
+            std::uint32_t programs;
+            std::uint64_t names_offset;
+            std::uint64_t directory_offset;
+            std::uint64_t size;
+        };
+
+        struct ImageName
+        {
+            SymbolKind kind;
+            OpCode code;
+            std::uint16_t reserved;
+            std::uint32_t length;
+        };
+
+        struct ImageProgram
+        {
+            std::uint32_t code;
+            std::uint32_t constants;
+            std::uint32_t variables;
+            std::uint32_t operators;
+            std::uint32_t max_depth;
+            std::uint32_t temporaries;
+            std::uint32_t outputs;
+            std::uint32_t reserved;
+        };
+
+        static constexpr char image_magic[4] = {'C', 'X', 'E', 'V'};
+        static constexpr std::uint32_t image_version = 1;
+        static constexpr std::size_t image_align = 16;
+
+        // FNV-1a, for fingerprints
+        inline auto fnv1a(std::uint64_t hash, const void *data, std::size_t size) -> std::uint64_t
+        {
+            auto bytes = static_cast<const unsigned char *>(data);
+            for (std::size_t i = 0; i < size; ++i)
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            return hash;
+        }
+
+        static constexpr std::uint64_t fnv1a_basis = 14695981039346656037ull;
+
+        // Byte buffer the writer appends sections to
+        class ImageBuffer
+        {
+            std::vector<char> bytes_;
+
+        public:
+            auto put(const void *data, std::size_t size) -> void
+            {
+                auto p = static_cast<const char *>(data);
+                bytes_.insert(bytes_.end(), p, p + size);
+            }
+
+            template <typename T>
+            auto put(const T &value) -> void
+            {
+                put(&value, sizeof(T));
+            }
+
+            auto align(std::size_t alignment) -> void
+            {
+                bytes_.resize((bytes_.size() + alignment - 1) / alignment * alignment, 0);
+            }
+
+            auto size() const -> std::size_t
+            {
+                return bytes_.size();
+            }
+
+            // Overwrites a value written earlier, e.g. an offset known only later
+            template <typename T>
+            auto patch(std::size_t offset, const T &value) -> void
+            {
+                std::memcpy(bytes_.data() + offset, &value, sizeof(T));
+            }
+
+            auto release() -> std::vector<char>
+            {
+                return std::move(bytes_);
+            }
+        };
+
+        // Read-only view of an image: checks the header and that every section lies inside
+        // the buffer, then hands out pointers into it without copying
+        template <typename KeyType, typename DataType>
+        class ImageView
+        {
+            const char *data_;
+            std::size_t size_;
+            const ImageHeader *header_;
+
+            auto at(std::uint64_t offset, std::uint64_t bytes) const -> const char *
+            {
+                if (offset > size_ || bytes > size_ - offset)
+                    throw std::runtime_error("Truncated image");
+                return data_ + offset;
+            }
+
+        public:
+            struct Name
+            {
+                SymbolKind kind;
+                OpCode code;
+                std::basic_string<KeyType> text;
+            };
+
+            struct ProgramView
+            {
+                const ImageProgram *header;
+                const Instruction *code;
+                const DataType *constants;
+                const std::uint32_t *variables;
+                const std::uint32_t *operators;
+            };
+
+            ImageView(const void *data, std::size_t size);
+
+            auto header() const -> const ImageHeader &
+            {
+                return *header_;
+            }
+
+            auto names() const -> std::vector<Name>;
+            auto program(std::size_t index) const -> ProgramView;
+        };
+
+        template <typename KeyType, typename DataType>
+        ImageView<KeyType, DataType>::ImageView(const void *data, std::size_t size)
+            : data_(static_cast<const char *>(data)), size_(size), header_(nullptr)
+        {
+            if (reinterpret_cast<std::uintptr_t>(data) % image_align)
+                throw std::invalid_argument("Image must be 16-byte aligned");
+            header_ = reinterpret_cast<const ImageHeader *>(at(0, sizeof(ImageHeader)));
+            if (std::memcmp(header_->magic, image_magic, sizeof(image_magic)))
+                throw std::runtime_error("Not an expression image");
+            if (header_->version != image_version)
+                throw std::runtime_error("Unsupported image version");
+            if (header_->byte_order != 0x01020304u || header_->key_size != sizeof(KeyType) ||
+                header_->data_size != sizeof(DataType))
+                throw std::runtime_error("Image written for another platform or type");
+            if (header_->size > size_)
+                throw std::runtime_error("Truncated image");
+            at(header_->directory_offset, std::uint64_t(header_->programs) * sizeof(std::uint64_t));
+            // Sections are read in place, so an offset the writer could not have produced is rejected
+            // before anything is cast; every entry takes at least sizeof(ImageName) bytes
+            if (header_->names_offset % image_align)
+                throw std::runtime_error("Misaligned image");
+            at(header_->names_offset, 0);
+            if (header_->names > (size_ - header_->names_offset) / sizeof(ImageName))
+                throw std::runtime_error("Truncated image");
+        }
+
+        template <typename KeyType, typename DataType>
+        auto ImageView<KeyType, DataType>::names() const -> std::vector<Name>
+        {
+            std::vector<Name> result;
+            result.reserve(header_->names);
+            std::uint64_t offset = header_->names_offset;
+            for (std::uint32_t i = 0; i < header_->names; ++i)
+            {
+                auto entry = reinterpret_cast<const ImageName *>(at(offset, sizeof(ImageName)));
+                const std::uint64_t bytes = std::uint64_t(entry->length) * sizeof(KeyType);
+                auto text = reinterpret_cast<const KeyType *>(at(offset + sizeof(ImageName), bytes));
+                result.push_back(Name{entry->kind, entry->code, std::basic_string<KeyType>(text, entry->length)});
+                offset += (sizeof(ImageName) + bytes + 7) / 8 * 8;
+            }
+            return result;
+        }
+
+        template <typename KeyType, typename DataType>
+        auto ImageView<KeyType, DataType>::program(std::size_t index) const -> ProgramView
+        {
+            if (index >= header_->programs)
+                throw std::out_of_range("Program index out of range");
+            std::uint64_t offset;
+            std::memcpy(&offset, data_ + header_->directory_offset + index * sizeof(std::uint64_t), sizeof(offset));
+            if (offset % image_align)
+                throw std::runtime_error("Misaligned image");
+            ProgramView view;
+            view.header = reinterpret_cast<const ImageProgram *>(at(offset, sizeof(ImageProgram)));
+            offset += sizeof(ImageProgram);
+            view.code = reinterpret_cast<const Instruction *>(at(offset, std::uint64_t(view.header->code) * sizeof(Instruction)));
+            offset = (offset + std::uint64_t(view.header->code) * sizeof(Instruction) + image_align - 1) / image_align * image_align;
+            view.constants = reinterpret_cast<const DataType *>(at(offset, std::uint64_t(view.header->constants) * sizeof(DataType)));
+            offset += std::uint64_t(view.header->constants) * sizeof(DataType);
+            view.variables = reinterpret_cast<const std::uint32_t *>(at(offset, std::uint64_t(view.header->variables) * 4));
+            offset += std::uint64_t(view.header->variables) * 4;
+            view.operators = reinterpret_cast<const std::uint32_t *>(at(offset, std::uint64_t(view.header->operators) * 4));
+            return view;
+        }
+
+        // A read-only file in memory: mmap where available, read into a buffer elsewhere
+        class MappedFile
+        {
+            void *map_ = nullptr;
+            std::size_t size_ = 0;
+            std::vector<char> buffer_; // fallback, over-allocated for 16-byte alignment
+            const char *data_ = nullptr;
+
+        public:
+            explicit MappedFile(const std::string &path);
+            MappedFile(const MappedFile &) = delete;
+            auto operator=(const MappedFile &) -> MappedFile & = delete;
+            ~MappedFile();
+
+            auto data() const -> const void *
+            {
+                return data_;
+            }
+
+            auto size() const -> std::size_t
+            {
+                return size_;
+            }
+        };
+
+        inline MappedFile::MappedFile(const std::string &path)
+        {
+#if EVAL_IMAGE_MMAP
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open " + path);
+            struct stat info;
+            if (::fstat(fd, &info) != 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot stat " + path);
+            }
+            size_ = static_cast<std::size_t>(info.st_size);
+            if (size_)
+            {
+                map_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map_ == MAP_FAILED)
+                {
+                    map_ = nullptr;
+                    ::close(fd);
+                    throw std::runtime_error("Cannot map " + path);
+                }
+                data_ = static_cast<const char *>(map_);
+            }
+            ::close(fd);
+#else
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("Cannot open " + path);
+            std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            size_ = bytes.size();
+            buffer_.resize(size_ + image_align);
+            auto base = reinterpret_cast<std::uintptr_t>(buffer_.data());
+            data_ = buffer_.data() + (image_align - base % image_align) % image_align;
+            std::memcpy(const_cast<char *>(data_), bytes.data(), size_);
+#endif
+        }
+
+        inline MappedFile::~MappedFile()
+        {
+#if EVAL_IMAGE_MMAP
+            if (map_)
+                ::munmap(map_, size_);
+#endif
+        }
+    }
+}
+
+#endif
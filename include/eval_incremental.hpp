@@ -0,0 +1,296 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_INCREMENTAL_HPP
+#define EVAL_INCREMENTAL_HPP
+
+#include "eval_core.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace ydog01
+{
+    namespace core
+    {
+        // A Program that keeps the value of every instruction between calls. value() compares
+        // the variable slots with the values it last saw and recomputes only the instructions
+        // downstream of the ones that changed, plus operators that are not pure (user operators
+        // unless marked otherwise), which run on every call together with everything above them.
+        // A variable such an operator takes by reference is written in place, and the loads of
+        // it that follow the call are recomputed, so the result matches Program::value().
+        // Variables are compared with ==, so a NaN always counts as changed.
+        template <typename DataType>
+        class IncrementalProgram
+        {
+            Program<DataType> program_;
+            std::vector<DataType> values_;              // result of each instruction
+            std::vector<DataType *> args_;              // operand values of each instruction, flattened
+            std::vector<std::size_t> arg_begin_;        // instruction i reads args_[arg_begin_[i], arg_begin_[i + 1])
+            std::vector<std::size_t> parents_;          // users of instruction i, flattened like args_
+            std::vector<std::size_t> parent_begin_;
+            std::vector<std::vector<std::size_t>> readers_; // instructions loading each variable slot
+            std::vector<std::size_t> impure_;
+            std::vector<DataType> seen_;
+            std::vector<char> dirty_;
+            std::size_t first_dirty_;                   // no instruction before it is dirty
+            std::vector<DataType> scratch_;
+            std::vector<DataType *> scratch_refs_;
+            std::size_t root_ = 0;
+            std::size_t recomputed_ = 0;
+            bool primed_ = false;
+
+            auto mark(std::size_t node) -> void;
+            auto compute(std::size_t node) -> void;
+            auto link_parents() -> void;
+
+        public:
+            explicit IncrementalProgram(Program<DataType> program);
+            // Operand pointers refer into values_, which moves along with its buffer
+            IncrementalProgram(IncrementalProgram &&) = default;
+            auto operator=(IncrementalProgram &&) -> IncrementalProgram & = default;
+            IncrementalProgram(const IncrementalProgram &) = delete;
+            auto operator=(const IncrementalProgram &) -> IncrementalProgram & = delete;
+
+            auto value() -> DataType;
+
+            // Drops every cached value, so the next value() recomputes the whole program
+            auto invalidate() -> void;
+
+            // Operators evaluated by the last value()
+            auto recomputed() const -> std::size_t;
+
+            auto program() const -> const Program<DataType> &;
+        };
+
+        template <typename DataType>
+        IncrementalProgram<DataType>::IncrementalProgram(Program<DataType> program)
+            : program_(std::move(program)), values_(program_.code.size()), readers_(program_.variables.size()), seen_(program_.variables.size()), dirty_(program_.code.size(), 0),
+              first_dirty_(program_.code.size())
+        {
+            // Replays the stack effect of the code with instruction numbers instead of values.
+            // A Store stands in for the value it copies, a Load reads the latest Store of its temporary.
+            std::vector<std::size_t> stack;
+            std::vector<std::size_t> stores(program_.temporaries, 0);
+            std::size_t widest = 0;
+            arg_begin_.reserve(program_.code.size() + 1);
+            for (std::size_t i = 0; i < program_.code.size(); ++i)
+            {
+                const auto &ins = program_.code[i];
+                arg_begin_.push_back(args_.size());
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                    stack.push_back(i);
+                    break;
+                case TokenType::Variale:
+                    readers_[ins.operand].push_back(i);
+                    stack.push_back(i);
+                    break;
+                case TokenType::Operator:
+                {
+                    const std::size_t base = stack.size() - ins.size;
+                    for (std::size_t j = base; j < stack.size(); ++j)
+                    {
+                        args_.push_back(&values_[stack[j]]);
+                    }
+                    stack.resize(base);
+                    stack.push_back(i);
+                    if (!program_.operators[ins.operand]->pure)
+                        impure_.push_back(i);
+                    if (ins.size > widest)
+                        widest = ins.size;
+                    break;
+                }
+                case TokenType::Store:
+                    args_.push_back(&values_[stack.back()]);
+                    stack.back() = i;
+                    stores[ins.operand] = i;
+                    break;
+                case TokenType::Load:
+                    args_.push_back(&values_[stores[ins.operand]]);
+                    stack.push_back(i);
+                    break;
+                }
+            }
+            arg_begin_.push_back(args_.size());
+            root_ = stack.front();//the first output, as value() returns
+            link_parents();
+            scratch_.resize(widest);
+            scratch_refs_.resize(widest);
+        }
+
+        // Inverts args_: the users of each instruction, counted first and then filled in place
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::link_parents() -> void
+        {
+            const std::size_t n = program_.code.size();
+            parent_begin_.assign(n + 1, 0);
+            for (auto arg : args_)
+                ++parent_begin_[static_cast<std::size_t>(arg - values_.data()) + 1];
+            for (std::size_t i = 0; i < n; ++i)
+                parent_begin_[i + 1] += parent_begin_[i];
+            parents_.resize(args_.size());
+            std::vector<std::size_t> fill(parent_begin_.begin(), parent_begin_.end() - 1);
+            for (std::size_t i = 0; i < n; ++i)
+                for (std::size_t j = arg_begin_[i]; j < arg_begin_[i + 1]; ++j)
+                    parents_[fill[static_cast<std::size_t>(args_[j] - values_.data())]++] = i;
+        }
+
+        // Only the sources are marked; value() passes dirtiness on to users while it sweeps
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::mark(std::size_t node) -> void
+        {
+            dirty_[node] = 1;
+            if (node < first_dirty_)
+                first_dirty_ = node;
+        }
+
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::compute(std::size_t node) -> void
+        {
+            const auto &ins = program_.code[node];
+            DataType *const *args = args_.data() + arg_begin_[node];
+            switch (ins.type)
+            {
+            case TokenType::Constant:
+                values_[node] = program_.constants[ins.operand];
+                break;
+            case TokenType::Variale:
+                values_[node] = *program_.variables[ins.operand];
+                break;
+            case TokenType::Store:
+            case TokenType::Load:
+                values_[node] = *args[0];
+                break;
+            case TokenType::Operator:
+                ++recomputed_;
+                switch (ins.code)
+                {
+                case OpCode::Add:
+                    values_[node] = *args[0] + *args[1];
+                    break;
+                case OpCode::Sub:
+                    values_[node] = *args[0] - *args[1];
+                    break;
+                case OpCode::Mul:
+                    values_[node] = *args[0] * *args[1];
+                    break;
+                case OpCode::Div:
+                    values_[node] = *args[0] / *args[1];
+                    break;
+                case OpCode::Neg:
+                    values_[node] = -*args[0];
+                    break;
+                case OpCode::None:
+                {
+                    // Variables finalize() marked are handed over by reference, as run() does;
+                    // every other argument is a copy, so writes to it cannot reach values_
+                    for (std::size_t j = 0; j < ins.size; ++j)
+                    {
+                        const auto &source = program_.code[static_cast<std::size_t>(args[j] - values_.data())];
+                        if (source.type == TokenType::Variale && source.size == 1)
+                            scratch_refs_[j] = program_.variables[source.operand].get();
+                        else
+                        {
+                            scratch_[j] = *args[j];
+                            scratch_refs_[j] = &scratch_[j];
+                        }
+                    }
+                    values_[node] = program_.operators[ins.operand]->function(
+                        ParamViewer<DataType>(scratch_refs_.data(), ins.size));
+                    // A write shows up in the loads that come after the call
+                    for (std::size_t j = 0; j < ins.size; ++j)
+                    {
+                        const auto &source = program_.code[static_cast<std::size_t>(args[j] - values_.data())];
+                        if (source.type == TokenType::Variale && source.size == 1)
+                        {
+                            const auto &readers = readers_[source.operand];
+                            for (auto it = std::upper_bound(readers.begin(), readers.end(), node); it != readers.end(); ++it)
+                                mark(*it);
+                        }
+                    }
+                    break;
+                }
+                default:
+                    values_[node] = ins.size == 2 ? builtin_binary(ins.code, *args[0], *args[1])
+                                                  : builtin_unary(ins.code, *args[0]);
+                    break;
+                }
+                break;
+            }
+        }
+
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::value() -> DataType
+        {
+            recomputed_ = 0;
+            const auto &variables = program_.variables;
+            if (!primed_)
+            {
+                for (std::size_t s = 0; s < variables.size(); ++s)
+                    seen_[s] = *variables[s];
+                for (std::size_t i = 0; i < program_.code.size(); ++i)
+                    mark(i);
+            }
+            else
+            {
+                for (std::size_t s = 0; s < variables.size(); ++s)
+                    if (!(*variables[s] == seen_[s]))
+                    {
+                        seen_[s] = *variables[s];
+                        for (auto reader : readers_[s])
+                            mark(reader);
+                    }
+                for (auto node : impure_)
+                    mark(node);
+            }
+
+            // Instruction order is a topological order, so users are always swept after their inputs
+            try
+            {
+                for (std::size_t node = first_dirty_; node < dirty_.size(); ++node)
+                    if (dirty_[node])
+                    {
+                        compute(node);
+                        dirty_[node] = 0;
+                        for (std::size_t j = parent_begin_[node]; j < parent_begin_[node + 1]; ++j)
+                            dirty_[parents_[j]] = 1;
+                    }
+            }
+            catch (...)
+            {
+                invalidate();
+                throw;
+            }
+            first_dirty_ = dirty_.size();
+            primed_ = true;
+            return values_[root_];
+        }
+
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::invalidate() -> void
+        {
+            primed_ = false;
+            first_dirty_ = dirty_.size();
+            std::fill(dirty_.begin(), dirty_.end(), 0);
+        }
+
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::recomputed() const -> std::size_t
+        {
+            return recomputed_;
+        }
+
+        template <typename DataType>
+        auto IncrementalProgram<DataType>::program() const -> const Program<DataType> &
+        {
+            return program_;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,244 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_INSTRUMENT_HPP
+#define EVAL_INSTRUMENT_HPP
+
+#include "eval_core.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Memory instrumentation, all opt-in:
+//  - count_allocations(fn) reports what fn allocated on the calling thread. The counters only
+//    move when exactly one translation unit defines EVAL_COUNT_ALLOCATIONS before including
+//    this header, which replaces the global operator new/delete; otherwise they stay zero and
+//    nothing is hooked.
+//  - footprint() estimates the heap bytes behind a Program, an Expression or a symbol trie
+//    (Evaluator::symbols()) from the container sizes, without touching the allocator.
+
+namespace ydog01
+{
+    namespace core
+    {
+        struct AllocationStats
+        {
+            std::size_t allocations = 0;
+            std::size_t deallocations = 0;
+            std::size_t bytes = 0; // requested by the allocations, not net of frees
+        };
+
+        // Counters of the calling thread; trivially initialized, so safe inside operator new
+        inline auto allocation_counters() -> AllocationStats &
+        {
+            static thread_local AllocationStats counters;
+            return counters;
+        }
+
+        // Runs fn and returns the allocations it made on this thread (zero without EVAL_COUNT_ALLOCATIONS)
+        template <typename Fn>
+        auto count_allocations(Fn &&fn) -> AllocationStats
+        {
+            const AllocationStats before = allocation_counters();
+            fn();
+            const AllocationStats &after = allocation_counters();
+            AllocationStats result;
+            result.allocations = after.allocations - before.allocations;
+            result.deallocations = after.deallocations - before.deallocations;
+            result.bytes = after.bytes - before.bytes;
+            return result;
+        }
+
+        // Estimated heap cost: nodes counts trie nodes, tokens or instructions, blocks the
+        // separate allocations and bytes what they request (allocator rounding not included)
+        struct Footprint
+        {
+            std::size_t nodes = 0;
+            std::size_t blocks = 0;
+            std::size_t bytes = 0;
+        };
+
+        // A shared object as if made by make_shared: the object and two counters behind a vtable
+        template <typename T>
+        constexpr auto shared_bytes() -> std::size_t
+        {
+            return sizeof(T) + 2 * sizeof(void *);
+        }
+
+        // Layout of the nodes of std::list and std::map in the common implementations
+        template <typename T>
+        struct ListNodeShape
+        {
+            void *links[2];
+            T value;
+        };
+
+        template <typename T>
+        struct TreeNodeShape
+        {
+            int colour;
+            void *links[3];
+            T value;
+        };
+
+        // Child storage of a trie node, not counting what the children own themselves
+        template <typename KeyType, typename ValueType>
+        auto map_footprint(const StdMap<KeyType, ValueType> &map) -> Footprint
+        {
+            Footprint result;
+            result.blocks = map.size();
+            result.bytes = map.size() * sizeof(TreeNodeShape<typename StdMap<KeyType, ValueType>::value_type>);
+            return result;
+        }
+
+        template <typename KeyType, typename ValueType>
+        auto map_footprint(const FlatMap<KeyType, ValueType> &map) -> Footprint
+        {
+            Footprint result;
+            result.blocks = map.capacity() ? 1 : 0;
+            result.bytes = map.capacity() * sizeof(typename FlatMap<KeyType, ValueType>::value_type);
+            return result;
+        }
+
+        template <typename KeyType, typename ValueType>
+        auto map_footprint(const AsciiMap<KeyType, ValueType> &map) -> Footprint
+        {
+            Footprint result;
+            result.blocks = map.capacity() ? 1 : 0;
+            result.bytes = map.capacity() * sizeof(typename AsciiMap<KeyType, ValueType>::value_type);
+            return result;
+        }
+
+        // A block shared by several snapshots is counted in each of them
+        template <typename KeyType, typename ValueType>
+        auto map_footprint(const SharedMap<KeyType, ValueType> &map) -> Footprint
+        {
+            Footprint result;
+            result.blocks = (map.shared() ? 1 : 0) + (map.capacity() ? 1 : 0);
+            result.bytes = map.shared() ? shared_bytes<FlatMap<KeyType, ValueType>>() +
+                                              map.capacity() * sizeof(typename SharedMap<KeyType, ValueType>::value_type)
+                                        : 0;
+            return result;
+        }
+
+        template <std::size_t I, template <typename, typename> class MapType, typename KeyType, typename... DataType>
+        auto node_data_footprint(const Node<MapType, KeyType, DataType...> &, Footprint &) ->
+            typename std::enable_if<I == sizeof...(DataType)>::type
+        {
+        }
+
+        template <std::size_t I, template <typename, typename> class MapType, typename KeyType, typename... DataType>
+        auto node_data_footprint(const Node<MapType, KeyType, DataType...> &node, Footprint &result) ->
+            typename std::enable_if<I < sizeof...(DataType)>::type
+        {
+            if (node.template has_data<I>())
+            {
+                ++result.blocks;
+                result.bytes += shared_bytes<typename std::tuple_element<I, std::tuple<DataType...>>::type>();
+            }
+            node_data_footprint<I + 1>(node, result);
+        }
+
+        // The whole trie below node, node itself included. Operators count with their fixed size only:
+        // what a std::function captures is out of sight.
+        template <template <typename, typename> class MapType, typename KeyType, typename... DataType>
+        auto footprint(const Node<MapType, KeyType, DataType...> &node) -> Footprint
+        {
+            Footprint result;
+            std::vector<const Node<MapType, KeyType, DataType...> *> pending(1, &node);
+            result.bytes = sizeof(node);
+            while (!pending.empty())
+            {
+                const auto current = pending.back();
+                pending.pop_back();
+                ++result.nodes;
+                node_data_footprint<0>(*current, result);
+                const Footprint children = map_footprint(current->get_child());
+                result.blocks += children.blocks;
+                result.bytes += children.bytes;
+                for (const auto &entry : current->get_child())
+                    pending.push_back(&entry.second);
+            }
+            return result;
+        }
+
+        // Instructions and pools; variables and operators are shared with the Evaluator and not counted
+        template <typename DataType>
+        auto footprint(const Program<DataType> &program) -> Footprint
+        {
+            Footprint result;
+            result.nodes = program.code.size();
+            result.bytes = program.code.capacity() * sizeof(Instruction) +
+                           program.constants.capacity() * sizeof(DataType) +
+                           program.variables.capacity() * sizeof(std::shared_ptr<DataType>) +
+                           program.operators.capacity() * sizeof(std::shared_ptr<Operator<DataType>>);
+            result.blocks = (program.code.capacity() ? 1 : 0) + (program.constants.capacity() ? 1 : 0) +
+                            (program.variables.capacity() ? 1 : 0) + (program.operators.capacity() ? 1 : 0);
+            return result;
+        }
+
+        // One list node per token, operator, variable and constant, plus the boxed constants
+        template <typename DataType, template <typename> class PtrType>
+        auto footprint(const Expression<DataType, PtrType> &expression) -> Footprint
+        {
+            Footprint result;
+            result.nodes = expression.index.size();
+            result.blocks = expression.index.size() + expression.operators.size() + expression.variables.size() +
+                            2 * expression.constants.size();
+            result.bytes =
+                expression.index.size() * sizeof(ListNodeShape<TokenType>) +
+                expression.operators.size() *
+                    sizeof(ListNodeShape<std::pair<PtrType<Operator<DataType>>, std::size_t>>) +
+                expression.variables.size() * sizeof(ListNodeShape<PtrType<DataType>>) +
+                expression.constants.size() * (sizeof(ListNodeShape<std::unique_ptr<DataType>>) + sizeof(DataType));
+            return result;
+        }
+    }
+}
+
+#ifdef EVAL_COUNT_ALLOCATIONS
+// Replacement global allocation functions feeding allocation_counters(); the array, nothrow
+// and sized forms of the standard library forward to these. GCC sees the malloc/free inside
+// them once they are inlined and takes the pairs as mismatched.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void *operator new(std::size_t size)
+{
+    auto &counters = ydog01::core::allocation_counters();
+    ++counters.allocations;
+    counters.bytes += size;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p)
+        ++ydog01::core::allocation_counters().deallocations;
+    std::free(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void *p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+#endif
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 11)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#endif
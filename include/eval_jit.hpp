@@ -0,0 +1,624 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_JIT_HPP
+#define EVAL_JIT_HPP
+
+#include "eval_core.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__) && defined(__x86_64__)
+#define EVAL_JIT_X64 1
+#include <sys/mman.h>
+#else
+#define EVAL_JIT_X64 0
+#endif
+
+namespace ydog01
+{
+    namespace core
+    {
+        // Everything the generated code reads, passed in rdi; all members are pointers so the
+        // offsets baked into the code stay valid
+        template <typename DataType>
+        struct JitFrame
+        {
+            DataType *stack;
+            const DataType *constants;
+            DataType *const *variables;
+            DataType *temps;
+            DataType **refs;
+            const std::shared_ptr<Operator<DataType>> *operators;
+            std::exception_ptr *error;
+        };
+
+        // Runs a user operator for the generated code; exceptions cannot unwind through it,
+        // so they are parked in the frame and rethrown once the code has returned
+        template <typename DataType>
+        auto jit_call(JitFrame<DataType> *frame, std::uint32_t operand, std::uint32_t size, std::uint32_t top) -> int
+        {
+            try
+            {
+                const RestoreRefs<DataType> restore(frame->refs + top, frame->stack + top, size);
+                frame->stack[top] =
+                    frame->operators[operand]->function(ParamViewer<DataType>(frame->refs + top, size));
+                return 1;
+            }
+            catch (...)
+            {
+                *frame->error = std::current_exception();
+                return 0;
+            }
+        }
+
+        // A Program compiled to x86-64 SSE2 code. Builtin arithmetic, negation, abs and sqrt are
+        // inlined, other builtins call libm directly and user operators go through jit_call.
+        // Only single-output Program<double> on x86-64 Linux is compiled; everything else, or a
+        // failed mmap, keeps running on the interpreter.
+        template <typename DataType>
+        class JitProgram
+        {
+            Program<DataType> program_;
+            std::vector<DataType *> variables_;
+            void *code_ = nullptr;
+            std::size_t size_ = 0;
+
+            auto compile(std::true_type) -> void;
+            auto compile(std::false_type) -> void;
+
+        public:
+            explicit JitProgram(Program<DataType> program);
+            JitProgram(JitProgram &&other) noexcept;
+            JitProgram(const JitProgram &) = delete;
+            auto operator=(const JitProgram &) -> JitProgram & = delete;
+            ~JitProgram();
+
+            // True when value() runs native code rather than the interpreter
+            auto native() const -> bool;
+            auto program() const -> const Program<DataType> &;
+
+            auto value() const -> DataType;
+            auto value(Workspace<DataType> &ws) const -> DataType;
+            // Native code has no per-instruction hooks, so profiled runs take the interpreter
+            template <typename Profile, typename = typename Profile::Scope>
+            auto value(Workspace<DataType> &ws, Profile &profile) const -> DataType;
+        };
+
+#if EVAL_JIT_X64
+        class X64Emitter
+        {
+        public:
+            std::vector<std::uint8_t> bytes;
+
+            enum Reg : int
+            {
+                RAX = 0,
+                RCX = 1,
+                RDX = 2,
+                RBX = 3,
+                RSI = 6,
+                RDI = 7,
+                R12 = 12,
+                R13 = 13,
+                R14 = 14,
+                R15 = 15
+            };
+
+            auto byte(std::uint8_t b) -> void
+            {
+                bytes.push_back(b);
+            }
+
+            auto dword(std::uint32_t v) -> void
+            {
+                for (int i = 0; i < 4; ++i)
+                    byte(static_cast<std::uint8_t>(v >> (8 * i)));
+            }
+
+            auto qword(std::uint64_t v) -> void
+            {
+                for (int i = 0; i < 8; ++i)
+                    byte(static_cast<std::uint8_t>(v >> (8 * i)));
+            }
+
+            auto rex(bool w, int reg, int rm) -> void
+            {
+                std::uint8_t r = static_cast<std::uint8_t>(0x40 | (w ? 8 : 0) | ((reg >> 3) << 2) | (rm >> 3));
+                if (r != 0x40)
+                    byte(r);
+            }
+
+            // [base + disp32]; rsp/r12 as base need a SIB byte
+            auto memory(int reg, int base, std::int32_t disp) -> void
+            {
+                byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+                if ((base & 7) == 4)
+                    byte(0x24);
+                dword(static_cast<std::uint32_t>(disp));
+            }
+
+            // Scalar SSE instruction xmm, [base + disp]
+            auto sse(std::uint8_t prefix, std::uint8_t op, int xmm, int base, std::int32_t disp) -> void
+            {
+                byte(prefix);
+                rex(false, xmm, base);
+                byte(0x0F);
+                byte(op);
+                memory(xmm, base, disp);
+            }
+
+            // Scalar SSE instruction xmm, xmm
+            auto sse(std::uint8_t prefix, std::uint8_t op, int dst, int src) -> void
+            {
+                byte(prefix);
+                rex(false, dst, src);
+                byte(0x0F);
+                byte(op);
+                byte(static_cast<std::uint8_t>(0xC0 | ((dst & 7) << 3) | (src & 7)));
+            }
+
+            auto mov_load(int dst, int base, std::int32_t disp) -> void
+            {
+                rex(true, dst, base);
+                byte(0x8B);
+                memory(dst, base, disp);
+            }
+
+            auto mov_store(int base, std::int32_t disp, int src) -> void
+            {
+                rex(true, src, base);
+                byte(0x89);
+                memory(src, base, disp);
+            }
+
+            auto mov_reg(int dst, int src) -> void
+            {
+                rex(true, src, dst);
+                byte(0x89);
+                byte(static_cast<std::uint8_t>(0xC0 | ((src & 7) << 3) | (dst & 7)));
+            }
+
+            auto mov_imm32(int dst, std::uint32_t v) -> void
+            {
+                rex(false, 0, dst);
+                byte(static_cast<std::uint8_t>(0xB8 | (dst & 7)));
+                dword(v);
+            }
+
+            auto mov_imm64(int dst, std::uint64_t v) -> void
+            {
+                rex(true, 0, dst);
+                byte(static_cast<std::uint8_t>(0xB8 | (dst & 7)));
+                qword(v);
+            }
+
+            // movq xmm, r64
+            auto movq(int xmm, int src) -> void
+            {
+                byte(0x66);
+                rex(true, xmm, src);
+                byte(0x0F);
+                byte(0x6E);
+                byte(static_cast<std::uint8_t>(0xC0 | ((xmm & 7) << 3) | (src & 7)));
+            }
+
+            auto push(int reg) -> void
+            {
+                rex(false, 0, reg);
+                byte(static_cast<std::uint8_t>(0x50 | (reg & 7)));
+            }
+
+            auto pop(int reg) -> void
+            {
+                rex(false, 0, reg);
+                byte(static_cast<std::uint8_t>(0x58 | (reg & 7)));
+            }
+
+            auto call(const void *target) -> void
+            {
+                mov_imm64(RAX, reinterpret_cast<std::uint64_t>(target));
+                byte(0xFF);
+                byte(0xD0);
+            }
+
+            // jz rel32 with a zero displacement; returns the position to patch
+            auto jz() -> std::size_t
+            {
+                byte(0x0F);
+                byte(0x84);
+                dword(0);
+                return bytes.size() - 4;
+            }
+
+            auto patch(std::size_t at, std::size_t target) -> void
+            {
+                auto rel = static_cast<std::uint32_t>(static_cast<std::int64_t>(target) -
+                                                      static_cast<std::int64_t>(at + 4));
+                std::memcpy(&bytes[at], &rel, 4);
+            }
+        };
+
+        // Stack slot d lives in xmm(d + 2) while d < jit_registers, in stack[d] otherwise.
+        // xmm0/xmm1 carry call arguments, xmm14/xmm15 are scratch.
+        class X64Compiler
+        {
+            using E = X64Emitter;
+
+            static constexpr std::size_t jit_registers = 12;
+            static constexpr int scratch = 14;
+            static constexpr int mask = 15;
+
+            E e_;
+
+            static auto in_reg(std::size_t slot) -> bool
+            {
+                return slot < jit_registers;
+            }
+
+            static auto xmm(std::size_t slot) -> int
+            {
+                return static_cast<int>(slot) + 2;
+            }
+
+            static auto offset(std::size_t slot) -> std::int32_t
+            {
+                return static_cast<std::int32_t>(slot * sizeof(double));
+            }
+
+            auto load(int dst, std::size_t slot) -> void
+            {
+                if (in_reg(slot))
+                {
+                    if (dst != xmm(slot))
+                        e_.sse(0xF2, 0x10, dst, xmm(slot));
+                }
+                else
+                    e_.sse(0xF2, 0x10, dst, E::RBX, offset(slot));
+            }
+
+            auto store(std::size_t slot, int src) -> void
+            {
+                if (in_reg(slot))
+                {
+                    if (src != xmm(slot))
+                        e_.sse(0xF2, 0x10, xmm(slot), src);
+                }
+                else
+                    e_.sse(0xF2, 0x11, src, E::RBX, offset(slot));
+            }
+
+            // Register holding the slot, loading memory slots into scratch
+            auto acquire(std::size_t slot) -> int
+            {
+                if (in_reg(slot))
+                    return xmm(slot);
+                load(scratch, slot);
+                return scratch;
+            }
+
+            auto release(std::size_t slot, int reg) -> void
+            {
+                if (!in_reg(slot))
+                    store(slot, reg);
+            }
+
+            // Calls clobber every xmm register, so register slots below end round-trip through stack[]
+            auto spill(std::size_t end) -> void
+            {
+                for (std::size_t i = 0; i < end && in_reg(i); ++i)
+                    e_.sse(0xF2, 0x11, xmm(i), E::RBX, offset(i));
+            }
+
+            auto reload(std::size_t end) -> void
+            {
+                for (std::size_t i = 0; i < end && in_reg(i); ++i)
+                    e_.sse(0xF2, 0x10, xmm(i), E::RBX, offset(i));
+            }
+
+            auto sign_op(std::size_t slot, std::uint8_t op, std::uint64_t bits) -> void
+            {
+                e_.mov_imm64(E::RAX, bits);
+                e_.movq(mask, E::RAX);
+                auto reg = acquire(slot);
+                e_.sse(0x66, op, reg, mask);
+                release(slot, reg);
+            }
+
+            static auto unary_function(OpCode code) -> double (*)(double);
+            static auto binary_function(OpCode code) -> double (*)(double, double);
+
+        public:
+            auto compile(const Program<double> &program) -> std::vector<std::uint8_t>;
+        };
+
+        inline auto X64Compiler::unary_function(OpCode code) -> double (*)(double)
+        {
+            switch (code)
+            {
+            case OpCode::Sin: return [](double x) -> double { return std::sin(x); };
+            case OpCode::Cos: return [](double x) -> double { return std::cos(x); };
+            case OpCode::Tan: return [](double x) -> double { return std::tan(x); };
+            case OpCode::Asin: return [](double x) -> double { return std::asin(x); };
+            case OpCode::Acos: return [](double x) -> double { return std::acos(x); };
+            case OpCode::Atan: return [](double x) -> double { return std::atan(x); };
+            case OpCode::Sinh: return [](double x) -> double { return std::sinh(x); };
+            case OpCode::Cosh: return [](double x) -> double { return std::cosh(x); };
+            case OpCode::Tanh: return [](double x) -> double { return std::tanh(x); };
+            case OpCode::Asinh: return [](double x) -> double { return std::asinh(x); };
+            case OpCode::Acosh: return [](double x) -> double { return std::acosh(x); };
+            case OpCode::Atanh: return [](double x) -> double { return std::atanh(x); };
+            case OpCode::Exp: return [](double x) -> double { return std::exp(x); };
+            case OpCode::Exp2: return [](double x) -> double { return std::exp2(x); };
+            case OpCode::Ln: return [](double x) -> double { return std::log(x); };
+            case OpCode::Log10: return [](double x) -> double { return std::log10(x); };
+            case OpCode::Log2: return [](double x) -> double { return std::log2(x); };
+            case OpCode::Log1p: return [](double x) -> double { return std::log1p(x); };
+            case OpCode::Cbrt: return [](double x) -> double { return std::cbrt(x); };
+            case OpCode::Ceil: return [](double x) -> double { return std::ceil(x); };
+            case OpCode::Floor: return [](double x) -> double { return std::floor(x); };
+            case OpCode::Round: return [](double x) -> double { return std::round(x); };
+            case OpCode::Trunc: return [](double x) -> double { return std::trunc(x); };
+            case OpCode::Erf: return [](double x) -> double { return std::erf(x); };
+            case OpCode::Erfc: return [](double x) -> double { return std::erfc(x); };
+            case OpCode::Tgamma: return [](double x) -> double { return std::tgamma(x); };
+            case OpCode::Lgamma: return [](double x) -> double { return std::lgamma(x); };
+            default: return nullptr;
+            }
+        }
+
+        inline auto X64Compiler::binary_function(OpCode code) -> double (*)(double, double)
+        {
+            switch (code)
+            {
+            case OpCode::Mod: return [](double x, double y) -> double { return std::fmod(x, y); };
+            case OpCode::Pow: return [](double x, double y) -> double { return std::pow(x, y); };
+            case OpCode::Atan2: return [](double x, double y) -> double { return std::atan2(x, y); };
+            case OpCode::Log: return [](double x, double y) -> double { return std::log(y) / std::log(x); };
+            case OpCode::Hypot: return [](double x, double y) -> double { return std::hypot(x, y); };
+            default: return nullptr;
+            }
+        }
+
+        inline auto X64Compiler::compile(const Program<double> &program) -> std::vector<std::uint8_t>
+        {
+            using Frame = JitFrame<double>;
+            // Five pushes leave rsp 16-byte aligned for the calls below
+            e_.push(E::RBX);
+            e_.push(E::R12);
+            e_.push(E::R13);
+            e_.push(E::R14);
+            e_.push(E::R15);
+            e_.mov_reg(E::R15, E::RDI);
+            e_.mov_load(E::RBX, E::RDI, offsetof(Frame, stack));
+            e_.mov_load(E::R12, E::RDI, offsetof(Frame, constants));
+            e_.mov_load(E::R13, E::RDI, offsetof(Frame, variables));
+            e_.mov_load(E::R14, E::RDI, offsetof(Frame, temps));
+
+            std::vector<std::size_t> failures;
+            std::size_t depth = 0;
+            for (const auto &ins : program.code)
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                {
+                    const int reg = in_reg(depth) ? xmm(depth) : scratch;
+                    e_.sse(0xF2, 0x10, reg, E::R12, offset(ins.operand));
+                    release(depth++, reg);
+                    break;
+                }
+                case TokenType::Variale:
+                {
+                    const int reg = in_reg(depth) ? xmm(depth) : scratch;
+                    e_.mov_load(E::RAX, E::R13, offset(ins.operand));
+                    e_.sse(0xF2, 0x10, reg, E::RAX, 0);
+                    if (ins.size)
+                    {
+                        // A user operator takes it by reference: refs[depth] = &variable
+                        e_.mov_load(E::RCX, E::R15, offsetof(Frame, refs));
+                        e_.mov_store(E::RCX, offset(depth), E::RAX);
+                    }
+                    release(depth++, reg);
+                    break;
+                }
+                case TokenType::Store:
+                    e_.sse(0xF2, 0x11, acquire(depth - 1), E::R14, offset(ins.operand));
+                    break;
+                case TokenType::Load:
+                {
+                    const int reg = in_reg(depth) ? xmm(depth) : scratch;
+                    e_.sse(0xF2, 0x10, reg, E::R14, offset(ins.operand));
+                    release(depth++, reg);
+                    break;
+                }
+                case TokenType::Operator:
+                {
+                    const std::size_t top = depth - ins.size;
+                    switch (ins.code)
+                    {
+                    case OpCode::Add:
+                    case OpCode::Sub:
+                    case OpCode::Mul:
+                    case OpCode::Div:
+                    {
+                        const std::uint8_t op = ins.code == OpCode::Add   ? 0x58
+                                                : ins.code == OpCode::Sub ? 0x5C
+                                                : ins.code == OpCode::Mul ? 0x59
+                                                                          : 0x5E;
+                        auto reg = acquire(top);
+                        if (in_reg(top + 1))
+                            e_.sse(0xF2, op, reg, xmm(top + 1));
+                        else
+                            e_.sse(0xF2, op, reg, E::RBX, offset(top + 1));
+                        release(top, reg);
+                        break;
+                    }
+                    case OpCode::Pos:
+                        break;
+                    case OpCode::Neg:
+                        sign_op(top, 0x57, 0x8000000000000000ull);//xorpd
+                        break;
+                    case OpCode::Abs:
+                        sign_op(top, 0x54, 0x7FFFFFFFFFFFFFFFull);//andpd
+                        break;
+                    case OpCode::Sqrt:
+                    {
+                        auto reg = acquire(top);
+                        e_.sse(0xF2, 0x51, reg, reg);
+                        release(top, reg);
+                        break;
+                    }
+                    case OpCode::None:
+                        spill(depth);
+                        e_.mov_reg(E::RDI, E::R15);
+                        e_.mov_imm32(E::RSI, ins.operand);
+                        e_.mov_imm32(E::RDX, ins.size);
+                        e_.mov_imm32(E::RCX, static_cast<std::uint32_t>(top));
+                        e_.call(reinterpret_cast<const void *>(&jit_call<double>));
+                        e_.byte(0x85);//test eax, eax
+                        e_.byte(0xC0);
+                        failures.push_back(e_.jz());
+                        reload(top + 1);
+                        break;
+                    default:
+                        spill(top);
+                        load(0, top);
+                        if (ins.size == 2)
+                        {
+                            load(1, top + 1);
+                            e_.call(reinterpret_cast<const void *>(binary_function(ins.code)));
+                        }
+                        else
+                            e_.call(reinterpret_cast<const void *>(unary_function(ins.code)));
+                        store(top, 0);
+                        reload(top);
+                        break;
+                    }
+                    depth = top + 1;
+                    break;
+                }
+                }
+
+            if (in_reg(0))
+                e_.sse(0xF2, 0x11, xmm(0), E::RBX, 0);
+            e_.mov_imm32(E::RAX, 1);
+            e_.byte(0xEB);//jmp over the failure path
+            e_.byte(0x02);
+            for (auto at : failures)
+                e_.patch(at, e_.bytes.size());
+            e_.byte(0x31);//xor eax, eax
+            e_.byte(0xC0);
+            e_.pop(E::R15);
+            e_.pop(E::R14);
+            e_.pop(E::R13);
+            e_.pop(E::R12);
+            e_.pop(E::RBX);
+            e_.byte(0xC3);
+            return std::move(e_.bytes);
+        }
+#endif
+
+        template <typename DataType>
+        JitProgram<DataType>::JitProgram(Program<DataType> program) : program_(std::move(program))
+        {
+            for (const auto &var : program_.variables)
+                variables_.push_back(var.get());
+            if (program_.outputs == 1)
+                compile(std::is_same<DataType, double>());
+        }
+
+        template <typename DataType>
+        JitProgram<DataType>::JitProgram(JitProgram &&other) noexcept
+            : program_(std::move(other.program_)), variables_(std::move(other.variables_)), code_(other.code_),
+              size_(other.size_)
+        {
+            other.code_ = nullptr;
+            other.size_ = 0;
+        }
+
+        template <typename DataType>
+        JitProgram<DataType>::~JitProgram()
+        {
+#if EVAL_JIT_X64
+            if (code_)
+                munmap(code_, size_);
+#endif
+        }
+
+        template <typename DataType>
+        auto JitProgram<DataType>::compile(std::true_type) -> void
+        {
+#if EVAL_JIT_X64
+            auto bytes = X64Compiler().compile(program_);
+            void *page = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (page == MAP_FAILED)
+                return;
+            std::memcpy(page, bytes.data(), bytes.size());
+            if (mprotect(page, bytes.size(), PROT_READ | PROT_EXEC) != 0)
+            {
+                munmap(page, bytes.size());
+                return;
+            }
+            code_ = page;
+            size_ = bytes.size();
+#endif
+        }
+
+        template <typename DataType>
+        auto JitProgram<DataType>::compile(std::false_type) -> void
+        {
+        }
+
+        template <typename DataType>
+        auto JitProgram<DataType>::native() const -> bool
+        {
+            return code_ != nullptr;
+        }
+
+        template <typename DataType>
+        auto JitProgram<DataType>::program() const -> const Program<DataType> &
+        {
+            return program_;
+        }
+
+        template <typename DataType>
+        auto JitProgram<DataType>::value() const -> DataType
+        {
+            Workspace<DataType> ws;
+            return value(ws);
+        }
+
+        template <typename DataType>
+        auto JitProgram<DataType>::value(Workspace<DataType> &ws) const -> DataType
+        {
+            if (!code_)
+                return program_.value(ws);
+            ws.reserve(program_);
+            std::exception_ptr error;
+            JitFrame<DataType> frame{ws.stack.data(),   program_.constants.data(), variables_.data(),
+                                     ws.temps.data(),   ws.refs.data(),            program_.operators.data(),
+                                     &error};
+            if (!reinterpret_cast<int (*)(JitFrame<DataType> *)>(code_)(&frame))
+                std::rethrow_exception(error);
+            return ws.stack[0];
+        }
+
+        template <typename DataType>
+        template <typename Profile, typename>
+        auto JitProgram<DataType>::value(Workspace<DataType> &ws, Profile &profile) const -> DataType
+        {
+            return program_.value(ws, profile);
+        }
+    }
+}
+
+#endif
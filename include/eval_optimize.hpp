@@ -0,0 +1,763 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_OPTIMIZE_HPP
+#define EVAL_OPTIMIZE_HPP
+
+#include "eval_core.hpp"
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ydog01
+{
+    namespace core
+    {
+        // Collapses every pure operator whose inputs are all constants into one constant.
+        // Returns the number of operator instructions removed.
+        template <typename DataType>
+        auto fold_constants(Program<DataType> &program) -> std::size_t;
+
+        struct CseStats
+        {
+            std::size_t invocations_before = 0;
+            std::size_t invocations_after = 0;
+            std::size_t shared_values = 0;//temporaries holding a value computed once and reused
+
+            auto eliminated() const -> std::size_t
+            {
+                return invocations_before - invocations_after;
+            }
+        };
+
+        // Hash-conses pure subtrees so each shared value is computed once, stored in a
+        // temporary and loaded at every later use
+        template <typename DataType>
+        auto eliminate_common_subexpressions(Program<DataType> &program) -> CseStats;
+
+        // Drops pool entries no instruction refers to and renumbers the operands
+        template <typename DataType>
+        auto compact_pools(Program<DataType> &program) -> void;
+
+        struct StrengthStats
+        {
+            std::size_t powers = 0;//integer powers turned into multiply chains
+            std::size_t divisions = 0;//divisions by a constant turned into multiplications
+            std::size_t polynomials = 0;//sums of monomials rewritten with Horner's scheme
+        };
+
+        // Rewrites builtin operators into cheaper equivalents: x^n with a small integer n becomes a
+        // multiply chain and polynomials in one variable use Horner's scheme. With fast_math a
+        // division by a constant also becomes a multiplication by its reciprocal.
+        template <typename DataType>
+        auto reduce_strength(Program<DataType> &program, bool fast_math = false) -> StrengthStats;
+
+        template <typename DataType>
+        class StrengthReducer
+        {
+            struct Term
+            {
+                bool negative;
+                std::size_t degree;
+                std::vector<std::size_t> coefficients;//input instructions multiplied together
+            };
+
+            const Program<DataType> &in_;
+            Program<DataType> out_;
+            bool fast_math_;
+            std::vector<std::size_t> first_kid_;
+            std::vector<std::size_t> kids_;
+            std::vector<std::size_t> parent_;
+            std::vector<std::size_t> in_start_;
+            std::vector<std::size_t> builtin_;
+
+        public:
+            static constexpr long long max_exponent = 4;//longest power unrolled into a multiply chain
+            static constexpr long long max_degree = 64;//highest power of x accepted inside a polynomial
+
+            StrengthReducer(const Program<DataType> &in, bool fast_math);
+
+            auto run(StrengthStats &stats) -> Program<DataType>;
+
+        private:
+            auto code_of(std::size_t node, std::size_t size) const -> OpCode;
+            auto is_sum(std::size_t node) const -> bool;
+            auto exponent_of(std::size_t node, long long &n) const -> bool;
+
+            auto emit_operator(OpCode code, std::size_t size) -> void;
+            auto emit_constant(DataType value) -> void;
+            auto emit_power(std::size_t start, long long n) -> void;
+            auto raise(const Instruction &leaf, long long n, std::size_t &square) -> void;
+            auto emit_horner(std::size_t node, std::size_t start) -> bool;
+        };
+
+        template <typename DataType>
+        auto integral_exponent(const DataType &value, long long &n) ->
+            typename std::enable_if<std::is_arithmetic<DataType>::value, bool>::type
+        {
+            if (!(value >= DataType(-StrengthReducer<DataType>::max_degree) &&
+                  value <= DataType(StrengthReducer<DataType>::max_degree)))
+                return false;
+            n = static_cast<long long>(value);
+            return DataType(n) == value;
+        }
+
+        template <typename DataType>
+        auto integral_exponent(const DataType &, long long &) ->
+            typename std::enable_if<!std::is_arithmetic<DataType>::value, bool>::type
+        {
+            return false;
+        }
+
+        template <typename DataType>
+        auto reciprocal(const DataType &value, DataType &result) ->
+            typename std::enable_if<std::is_floating_point<DataType>::value, bool>::type
+        {
+            if (value == DataType(0))
+                return false;
+            result = DataType(1) / value;
+            return true;
+        }
+
+        template <typename DataType>
+        auto reciprocal(const DataType &, DataType &) ->
+            typename std::enable_if<!std::is_floating_point<DataType>::value, bool>::type
+        {
+            return false;
+        }
+
+        // Byte image of a constant, empty when the type cannot be compared that way
+        template <typename DataType>
+        auto constant_key(const DataType &value) ->
+            typename std::enable_if<std::is_trivially_copyable<DataType>::value, std::string>::type
+        {
+            return std::string(reinterpret_cast<const char *>(&value), sizeof(DataType));
+        }
+
+        template <typename DataType>
+        auto constant_key(const DataType &) ->
+            typename std::enable_if<!std::is_trivially_copyable<DataType>::value, std::string>::type
+        {
+            return std::string();
+        }
+
+        template <typename DataType>
+        auto fold_constants(Program<DataType> &program) -> std::size_t
+        {
+            Program<DataType> result(program.arena());
+            std::vector<bool> is_constant;
+            std::vector<DataType> args;
+            std::vector<DataType *> refs;
+            std::size_t folded = 0;
+
+            for (const auto &ins : program.code)
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                    result.push_constant(program.constants[ins.operand]);
+                    is_constant.push_back(true);
+                    break;
+                case TokenType::Variale:
+                    result.push_variable(program.variables[ins.operand]);
+                    is_constant.push_back(false);
+                    break;
+                case TokenType::Operator:
+                {
+                    const auto &op = program.operators[ins.operand];
+                    const std::size_t base = is_constant.size() - ins.size;
+                    bool foldable = op->pure;
+                    for (std::size_t i = base; foldable && i < is_constant.size(); ++i)
+                        foldable = is_constant[i];
+                    is_constant.resize(base);
+
+                    // All inputs are the trailing constants of result, so they can be replaced in place
+                    if (foldable)
+                    {
+                        args.assign(result.constants.end() - ins.size, result.constants.end());
+                        refs.resize(args.size());
+                        for (std::size_t i = 0; i < args.size(); ++i)
+                            refs[i] = &args[i];
+                        try
+                        {
+                            DataType value = op->function(ParamViewer<DataType>(refs.data(), ins.size));
+                            result.code.resize(result.code.size() - ins.size);
+                            result.constants.resize(result.constants.size() - ins.size);
+                            result.push_constant(std::move(value));
+                            is_constant.push_back(true);
+                            ++folded;
+                            break;
+                        }
+                        catch (const std::exception &)
+                        {
+                            // Leave the operator in place so evaluation reports the error
+                        }
+                    }
+                    result.push_operator(op, ins.size);
+                    is_constant.push_back(false);
+                    break;
+                }
+                case TokenType::Store:
+                    result.push_store(ins.operand);
+                    is_constant.back() = false;
+                    break;
+                case TokenType::Load:
+                    result.push_load(ins.operand);
+                    is_constant.push_back(false);
+                    break;
+                }
+
+            result.temporaries = program.temporaries;
+            result.outputs = program.outputs;
+            result.finalize();
+            program = std::move(result);
+            return folded;
+        }
+
+        template <typename DataType>
+        auto eliminate_common_subexpressions(Program<DataType> &program) -> CseStats
+        {
+            CseStats stats;
+            const auto &code = program.code;
+            const std::size_t none = static_cast<std::size_t>(-1);
+
+            // Pass 1: value-number every instruction and count how often each operator value is computed
+            std::map<std::vector<std::uintptr_t>, std::size_t> numbering;
+            std::map<std::string, std::size_t> constant_ids;
+            std::vector<std::size_t> ids(code.size());
+            std::vector<std::size_t> uses;
+            std::vector<std::size_t> stack;
+            auto fresh = [&uses]() -> std::size_t
+            {
+                uses.push_back(0);
+                return uses.size() - 1;
+            };
+            for (std::size_t i = 0; i < code.size(); ++i)
+            {
+                const auto &ins = code[i];
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                {
+                    auto key = constant_key(program.constants[ins.operand]);
+                    if (key.empty())
+                        ids[i] = fresh();
+                    else
+                    {
+                        auto it = constant_ids.find(key);
+                        ids[i] = it != constant_ids.end() ? it->second : (constant_ids[key] = fresh());
+                    }
+                    stack.push_back(ids[i]);
+                    break;
+                }
+                case TokenType::Variale:
+                {
+                    std::vector<std::uintptr_t> key{
+                        1, reinterpret_cast<std::uintptr_t>(program.variables[ins.operand].get())};
+                    auto it = numbering.find(key);
+                    ids[i] = it != numbering.end() ? it->second : (numbering[key] = fresh());
+                    stack.push_back(ids[i]);
+                    break;
+                }
+                case TokenType::Operator:
+                {
+                    ++stats.invocations_before;
+                    const auto &op = program.operators[ins.operand];
+                    const std::size_t base = stack.size() - ins.size;
+                    if (op->pure)
+                    {
+                        std::vector<std::uintptr_t> key{2, reinterpret_cast<std::uintptr_t>(op.get()), ins.size};
+                        key.insert(key.end(), stack.begin() + base, stack.end());
+                        auto it = numbering.find(key);
+                        ids[i] = it != numbering.end() ? it->second : (numbering[key] = fresh());
+                    }
+                    else
+                    {
+                        // An impure operator may write the variables it was handed (or anything
+                        // else), so nothing computed before it may stand in for a later copy
+                        ids[i] = fresh();
+                        numbering.clear();
+                    }
+                    ++uses[ids[i]];
+                    stack.resize(base);
+                    stack.push_back(ids[i]);
+                    break;
+                }
+                case TokenType::Store:
+                    ids[i] = stack.back();
+                    break;
+                case TokenType::Load:
+                    ids[i] = fresh();
+                    stack.push_back(ids[i]);
+                    break;
+                }
+            }
+
+            // Pass 2: compute a shared value the first time and store it; later copies of its
+            // subtree are a contiguous tail of the output and collapse into one load
+            std::vector<Instruction> out;
+            out.reserve(code.size());
+            std::vector<std::size_t> starts;
+            std::vector<std::size_t> temp_of(uses.size(), none);
+            std::size_t temps = program.temporaries;
+            for (std::size_t i = 0; i < code.size(); ++i)
+            {
+                const auto &ins = code[i];
+                if (ins.type == TokenType::Operator)
+                {
+                    const std::size_t base = starts.size() - ins.size;
+                    const std::size_t start = ins.size ? starts[base] : out.size();
+                    starts.resize(base);
+                    const auto id = ids[i];
+                    if (uses[id] > 1 && temp_of[id] != none)
+                    {
+                        out.resize(start);
+                        out.push_back({TokenType::Load, 0, static_cast<std::uint32_t>(temp_of[id])});
+                    }
+                    else
+                    {
+                        out.push_back(ins);
+                        if (uses[id] > 1)
+                        {
+                            temp_of[id] = temps++;
+                            out.push_back({TokenType::Store, 0, static_cast<std::uint32_t>(temp_of[id])});
+                        }
+                    }
+                    starts.push_back(start);
+                }
+                else if (ins.type == TokenType::Store)
+                    out.push_back(ins);
+                else
+                {
+                    starts.push_back(out.size());
+                    out.push_back(ins);
+                }
+            }
+
+            // A value counted twice may have lost every later use to an enclosing shared value
+            std::vector<std::size_t> loads(temps, 0);
+            for (const auto &ins : out)
+                if (ins.type == TokenType::Load)
+                    ++loads[ins.operand];
+            std::vector<std::size_t> renumber(temps, none);
+            std::size_t kept = program.temporaries;
+            for (std::size_t t = 0; t < temps; ++t)
+                if (t < program.temporaries)
+                    renumber[t] = t;
+                else if (loads[t])
+                    renumber[t] = kept++;
+            program.code.clear();
+            for (const auto &ins : out)
+            {
+                if (ins.type == TokenType::Store || ins.type == TokenType::Load)
+                {
+                    if (renumber[ins.operand] == none)
+                        continue;
+                    program.code.push_back({ins.type, 0, static_cast<std::uint32_t>(renumber[ins.operand])});
+                }
+                else
+                    program.code.push_back(ins);
+                if (ins.type == TokenType::Operator)
+                    ++stats.invocations_after;
+            }
+            stats.shared_values = kept - program.temporaries;
+            program.temporaries = kept;
+            compact_pools(program);
+            program.finalize();
+            return stats;
+        }
+
+        template <typename DataType>
+        auto compact_pools(Program<DataType> &program) -> void
+        {
+            const std::size_t none = static_cast<std::size_t>(-1);
+            std::vector<std::size_t> constant_map(program.constants.size(), none);
+            std::vector<std::size_t> variable_map(program.variables.size(), none);
+            std::vector<std::size_t> operator_map(program.operators.size(), none);
+            decltype(program.constants) constants(program.constants.get_allocator());
+            decltype(program.variables) variables(program.variables.get_allocator());
+            decltype(program.operators) operators(program.operators.get_allocator());
+            for (auto &ins : program.code)
+                switch (ins.type)
+                {
+                case TokenType::Constant:
+                    if (constant_map[ins.operand] == none)
+                    {
+                        constant_map[ins.operand] = constants.size();
+                        constants.push_back(program.constants[ins.operand]);
+                    }
+                    ins.operand = static_cast<std::uint32_t>(constant_map[ins.operand]);
+                    break;
+                case TokenType::Variale:
+                    if (variable_map[ins.operand] == none)
+                    {
+                        variable_map[ins.operand] = variables.size();
+                        variables.push_back(program.variables[ins.operand]);
+                    }
+                    ins.operand = static_cast<std::uint32_t>(variable_map[ins.operand]);
+                    break;
+                case TokenType::Operator:
+                    if (operator_map[ins.operand] == none)
+                    {
+                        operator_map[ins.operand] = operators.size();
+                        operators.push_back(program.operators[ins.operand]);
+                    }
+                    ins.operand = static_cast<std::uint32_t>(operator_map[ins.operand]);
+                    break;
+                default:
+                    break;
+                }
+            program.constants = std::move(constants);
+            program.variables = std::move(variables);
+            program.operators = std::move(operators);
+        }
+
+        template <typename DataType>
+        constexpr long long StrengthReducer<DataType>::max_exponent;
+
+        template <typename DataType>
+        constexpr long long StrengthReducer<DataType>::max_degree;
+
+        template <typename DataType>
+        StrengthReducer<DataType>::StrengthReducer(const Program<DataType> &in, bool fast_math)
+            : in_(in), out_(in.arena()), fast_math_(fast_math), first_kid_(in.code.size()),
+              parent_(in.code.size(), static_cast<std::size_t>(-1)), in_start_(in.code.size()),
+              builtin_(static_cast<std::size_t>(OpCode::Neg) + 1, static_cast<std::size_t>(-1))
+        {
+            out_.constants = in.constants;
+            out_.variables = in.variables;
+            out_.operators = in.operators;
+            out_.temporaries = in.temporaries;
+            out_.outputs = in.outputs;
+            for (std::size_t i = 0; i < in.operators.size(); ++i)
+            {
+                auto code = static_cast<std::size_t>(in.operators[i]->code);
+                if (code < builtin_.size() && builtin_[code] == static_cast<std::size_t>(-1))
+                    builtin_[code] = i;
+            }
+
+            std::vector<std::size_t> stack;
+            for (std::size_t i = 0; i < in.code.size(); ++i)
+            {
+                const auto &ins = in.code[i];
+                if (ins.type == TokenType::Store)
+                    continue;
+                in_start_[i] = i;
+                if (ins.type == TokenType::Operator)
+                {
+                    const std::size_t base = stack.size() - ins.size;
+                    first_kid_[i] = kids_.size();
+                    if (ins.size)
+                        in_start_[i] = in_start_[stack[base]];
+                    for (std::size_t j = base; j < stack.size(); ++j)
+                    {
+                        kids_.push_back(stack[j]);
+                        parent_[stack[j]] = i;
+                    }
+                    stack.resize(base);
+                }
+                stack.push_back(i);
+            }
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::code_of(std::size_t node, std::size_t size) const -> OpCode
+        {
+            const auto &ins = in_.code[node];
+            if (ins.type != TokenType::Operator || ins.size != size)
+                return OpCode::None;
+            return in_.operators[ins.operand]->code;
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::is_sum(std::size_t node) const -> bool
+        {
+            auto code = code_of(node, 2);
+            return code == OpCode::Add || code == OpCode::Sub;
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::exponent_of(std::size_t node, long long &n) const -> bool
+        {
+            const auto &ins = in_.code[kids_[first_kid_[node] + 1]];
+            return ins.type == TokenType::Constant && integral_exponent(in_.constants[ins.operand], n);
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::emit_operator(OpCode code, std::size_t size) -> void
+        {
+            auto &index = builtin_[static_cast<std::size_t>(code)];
+            if (index == static_cast<std::size_t>(-1))
+            {
+                index = out_.operators.size();
+                out_.operators.push_back(builtin_operator<DataType>(code));
+            }
+            out_.code.push_back(
+                {TokenType::Operator, static_cast<std::uint32_t>(size), static_cast<std::uint32_t>(index), code});
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::emit_constant(DataType value) -> void
+        {
+            out_.code.push_back({TokenType::Constant, 0, static_cast<std::uint32_t>(out_.constants.size())});
+            out_.constants.push_back(std::move(value));
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::raise(const Instruction &leaf, long long n, std::size_t &square) -> void
+        {
+            // The base is on top of the stack; leave base^n there instead
+            if (n == 1)
+                return;
+            if (n % 2)
+            {
+                raise(leaf, n - 1, square);
+                out_.code.push_back(leaf);
+            }
+            else if (n == 2)
+                out_.code.push_back(leaf);
+            else
+            {
+                raise(leaf, n / 2, square);
+                if (square == static_cast<std::size_t>(-1))
+                    square = out_.temporaries++;
+                out_.push_store(square);
+                out_.push_load(square);
+            }
+            emit_operator(OpCode::Mul, 2);
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::emit_power(std::size_t start, long long n) -> void
+        {
+            // The base occupies out_.code[start, end); reuse a lone leaf, otherwise keep it in a temporary
+            Instruction leaf = out_.code.back();
+            const bool single = out_.code.size() - start == 1 &&
+                                (leaf.type == TokenType::Constant || leaf.type == TokenType::Variale ||
+                                 leaf.type == TokenType::Load);
+            if (!single)
+            {
+                auto temp = out_.temporaries++;
+                out_.push_store(temp);
+                leaf = {TokenType::Load, 0, static_cast<std::uint32_t>(temp)};
+            }
+            if (n < 0)
+            {
+                out_.code.insert(out_.code.begin() + start,
+                                 {TokenType::Constant, 0, static_cast<std::uint32_t>(out_.constants.size())});
+                out_.constants.push_back(DataType(1));
+            }
+            std::size_t square = static_cast<std::size_t>(-1);
+            raise(leaf, n < 0 ? -n : n, square);
+            if (n < 0)
+                emit_operator(OpCode::Div, 2);
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::emit_horner(std::size_t node, std::size_t start) -> bool
+        {
+            for (std::size_t i = in_start_[node]; i < node; ++i)
+                if (in_.code[i].type == TokenType::Store || in_.code[i].type == TokenType::Load)
+                    return false;
+
+            // Flatten the +/- chain into signed terms, left to right
+            std::vector<std::pair<std::size_t, bool>> pending{{node, false}};
+            std::vector<std::pair<std::size_t, bool>> sums;
+            while (!pending.empty())
+            {
+                auto item = pending.back();
+                pending.pop_back();
+                if (is_sum(item.first))
+                {
+                    auto kid = first_kid_[item.first];
+                    bool minus = code_of(item.first, 2) == OpCode::Sub;
+                    pending.push_back({kids_[kid + 1], item.second != minus});
+                    pending.push_back({kids_[kid], item.second});
+                }
+                else
+                    sums.push_back(item);
+            }
+
+            // Split every term into factors: variables, x^k and constants
+            struct Factor
+            {
+                std::size_t node;
+                const DataType *variable;
+                long long degree;
+            };
+            std::vector<std::vector<Factor>> factors(sums.size());
+            const DataType *x = nullptr;
+            std::uint32_t x_operand = 0;
+            long long best = 0;
+            for (std::size_t t = 0; t < sums.size(); ++t)
+            {
+                std::vector<std::size_t> work{sums[t].first};
+                while (!work.empty())
+                {
+                    auto n = work.back();
+                    work.pop_back();
+                    const auto &ins = in_.code[n];
+                    long long k;
+                    if (code_of(n, 2) == OpCode::Mul)
+                    {
+                        work.push_back(kids_[first_kid_[n] + 1]);
+                        work.push_back(kids_[first_kid_[n]]);
+                    }
+                    else if (ins.type == TokenType::Constant)
+                        factors[t].push_back({n, nullptr, 0});
+                    else if (ins.type == TokenType::Variale)
+                        factors[t].push_back({n, in_.variables[ins.operand].get(), 1});
+                    else if (code_of(n, 2) == OpCode::Pow && exponent_of(n, k) && k >= 2 &&
+                             in_.code[kids_[first_kid_[n]]].type == TokenType::Variale)
+                        factors[t].push_back(
+                            {n, in_.variables[in_.code[kids_[first_kid_[n]]].operand].get(), k});
+                    else
+                        return false;
+                }
+                // The polynomial variable is the one reaching the highest degree in a single term
+                for (const auto &f : factors[t])
+                {
+                    if (!f.variable)
+                        continue;
+                    long long degree = 0;
+                    for (const auto &g : factors[t])
+                        if (g.variable == f.variable)
+                            degree += g.degree;
+                    if (degree > best)
+                    {
+                        best = degree;
+                        x = f.variable;
+                        auto base = in_.code[f.node].type == TokenType::Variale ? f.node : kids_[first_kid_[f.node]];
+                        x_operand = in_.code[base].operand;
+                    }
+                }
+            }
+            if (best < 2)
+                return false;
+
+            std::vector<std::vector<Term>> by_degree(static_cast<std::size_t>(best) + 1);
+            std::size_t nonconstant = 0;
+            for (std::size_t t = 0; t < sums.size(); ++t)
+            {
+                Term term{sums[t].second, 0, {}};
+                for (const auto &f : factors[t])
+                    if (f.variable == x)
+                        term.degree += static_cast<std::size_t>(f.degree);
+                    else if (f.degree <= 1)
+                        term.coefficients.push_back(f.node);
+                    else
+                        return false;
+                if (term.degree)
+                    ++nonconstant;
+                by_degree[term.degree].push_back(std::move(term));
+            }
+            // A single power of x gains nothing over the multiply chain
+            if (nonconstant < 2)
+                return false;
+
+            // ((c_n * x + c_n-1) * x + ...) * x + c_0
+            out_.code.resize(start);
+            auto emit_coefficient = [this](const Term &term)
+            {
+                if (term.coefficients.empty())
+                    emit_constant(DataType(1));
+                for (std::size_t i = 0; i < term.coefficients.size(); ++i)
+                {
+                    out_.code.push_back(in_.code[term.coefficients[i]]);
+                    if (i)
+                        emit_operator(OpCode::Mul, 2);
+                }
+            };
+            for (std::size_t k = by_degree.size(); k-- > 0;)
+            {
+                if (k + 1 < by_degree.size())
+                {
+                    out_.code.push_back({TokenType::Variale, 0, x_operand});
+                    emit_operator(OpCode::Mul, 2);
+                }
+                for (std::size_t i = 0; i < by_degree[k].size(); ++i)
+                {
+                    const auto &term = by_degree[k][i];
+                    emit_coefficient(term);
+                    if (k + 1 == by_degree.size() && i == 0)
+                    {
+                        if (term.negative)
+                            emit_operator(OpCode::Neg, 1);
+                    }
+                    else
+                        emit_operator(term.negative ? OpCode::Sub : OpCode::Add, 2);
+                }
+            }
+            return true;
+        }
+
+        template <typename DataType>
+        auto StrengthReducer<DataType>::run(StrengthStats &stats) -> Program<DataType>
+        {
+            std::vector<std::size_t> starts;
+            for (std::size_t i = 0; i < in_.code.size(); ++i)
+            {
+                const auto &ins = in_.code[i];
+                if (ins.type == TokenType::Store)
+                {
+                    out_.code.push_back(ins);
+                    continue;
+                }
+                if (ins.type != TokenType::Operator)
+                {
+                    starts.push_back(out_.code.size());
+                    out_.code.push_back(ins);
+                    continue;
+                }
+
+                const std::size_t base = starts.size() - ins.size;
+                const std::size_t start = ins.size ? starts[base] : out_.code.size();
+                starts.resize(base);
+                const auto code = code_of(i, ins.size);
+                long long n;
+                DataType inverse;
+                if (is_sum(i) && (parent_[i] == static_cast<std::size_t>(-1) || !is_sum(parent_[i])) &&
+                    emit_horner(i, start))
+                    ++stats.polynomials;
+                else if (code == OpCode::Pow && ins.size == 2 && exponent_of(i, n) && n != 0 &&
+                         n >= -max_exponent && n <= max_exponent)
+                {
+                    out_.code.pop_back();
+                    emit_power(start, n);
+                    ++stats.powers;
+                }
+                else if (fast_math_ && code == OpCode::Div && ins.size == 2 &&
+                         out_.code.back().type == TokenType::Constant &&
+                         reciprocal(out_.constants[out_.code.back().operand], inverse))
+                {
+                    out_.code.pop_back();
+                    emit_constant(inverse);
+                    emit_operator(OpCode::Mul, 2);
+                    ++stats.divisions;
+                }
+                else
+                    out_.code.push_back(ins);
+                starts.push_back(start);
+            }
+            return std::move(out_);
+        }
+
+        template <typename DataType>
+        auto reduce_strength(Program<DataType> &program, bool fast_math) -> StrengthStats
+        {
+            StrengthStats stats;
+            auto result = StrengthReducer<DataType>(program, fast_math).run(stats);
+            compact_pools(result);
+            result.finalize();
+            program = std::move(result);
+            return stats;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,305 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_PARALLEL_HPP
+#define EVAL_PARALLEL_HPP
+
+#include "eval_core.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ydog01
+{
+    namespace core
+    {
+        // Work-stealing pool: each worker pops the newest task of its own deque and steals the
+        // oldest task of another one when it runs dry. The thread calling parallel_for works
+        // too, so a pool of N threads starts N - 1 workers, and a pool of 1 runs inline.
+        class ThreadPool
+        {
+            struct Queue
+            {
+                std::mutex mutex;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            struct Group
+            {
+                std::mutex mutex;
+                std::condition_variable done;
+                std::size_t remaining = 0;
+                std::atomic<bool> failed{false};
+                std::exception_ptr error;
+            };
+
+            std::vector<std::unique_ptr<Queue>> queues_;
+            std::vector<std::thread> workers_;
+            std::mutex sleep_mutex_;
+            std::condition_variable wake_;
+            std::atomic<std::size_t> pending_{0};
+            std::atomic<std::size_t> next_{0};
+            std::atomic<bool> stop_{false};
+
+            // Worker index of the calling thread in this pool, npos for outside threads
+            auto self() const -> std::size_t;
+            auto push(std::function<void()> task) -> void;
+            auto try_run_one(std::size_t self) -> bool;
+            auto work(std::size_t index) -> void;
+
+            static auto current() -> std::pair<const ThreadPool *, std::size_t> &
+            {
+                static thread_local std::pair<const ThreadPool *, std::size_t> worker(nullptr, 0);
+                return worker;
+            }
+
+        public:
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+            // 0 picks std::thread::hardware_concurrency()
+            explicit ThreadPool(std::size_t threads = 0);
+            ThreadPool(const ThreadPool &) = delete;
+            auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+            ~ThreadPool();
+
+            // Threads taking part in parallel_for, the caller included
+            auto size() const -> std::size_t;
+
+            // Runs task(i) for every i in [0, count) and returns once all have finished.
+            // After the first exception the remaining tasks are skipped and it is rethrown here.
+            template <typename Task>
+            auto parallel_for(std::size_t count, Task task) -> void;
+        };
+
+        // Evaluates program over rows [0, rows) like Program::value_batch, chunk rows per task.
+        // chunk 0 picks a multiple of Program::batch_tile giving each thread a few chunks.
+        template <typename DataType>
+        auto parallel_batch(ThreadPool &pool, const Program<DataType> &program,
+                            const std::vector<Binding<DataType>> &inputs, DataType *out, std::size_t rows,
+                            std::size_t chunk = 0) -> void;
+
+        // out[i] = programs[i].value(), chunk programs per task; programs reading the same
+        // variables are fine as long as nobody writes them meanwhile
+        template <typename DataType>
+        auto parallel_values(ThreadPool &pool, const std::vector<Program<DataType>> &programs, DataType *out,
+                             std::size_t chunk = 0) -> void;
+
+        // out[i] = programs[i].value(ws, frames[i])
+        template <typename DataType>
+        auto parallel_values(ThreadPool &pool, const std::vector<Program<DataType>> &programs,
+                             const std::vector<Frame<DataType>> &frames, DataType *out, std::size_t chunk = 0)
+            -> void;
+
+        inline ThreadPool::ThreadPool(std::size_t threads)
+        {
+            if (!threads)
+                threads = std::thread::hardware_concurrency();
+            if (!threads)
+                threads = 1;
+            for (std::size_t i = 0; i < threads; ++i)
+                queues_.emplace_back(new Queue);
+            for (std::size_t i = 0; i + 1 < threads; ++i)
+                workers_.emplace_back(&ThreadPool::work, this, i);
+        }
+
+        inline ThreadPool::~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto &worker : workers_)
+                worker.join();
+        }
+
+        inline auto ThreadPool::size() const -> std::size_t
+        {
+            return queues_.size();
+        }
+
+        inline auto ThreadPool::self() const -> std::size_t
+        {
+            const auto &worker = current();
+            if (worker.first != this)
+                return npos;
+            return worker.second;
+        }
+
+        inline auto ThreadPool::push(std::function<void()> task) -> void
+        {
+            auto index = self();
+            if (index == npos)
+                index = next_++ % queues_.size();
+            {
+                std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+                queues_[index]->tasks.push_back(std::move(task));
+            }
+            ++pending_;
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+            }
+            wake_.notify_one();
+        }
+
+        inline auto ThreadPool::try_run_one(std::size_t self) -> bool
+        {
+            std::function<void()> task;
+            if (self != npos)
+            {
+                auto &own = *queues_[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty())
+                {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                }
+            }
+            const std::size_t start = self == npos ? 0 : self + 1;
+            for (std::size_t i = 0; !task && i < queues_.size(); ++i)
+            {
+                auto &victim = *queues_[(start + i) % queues_.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                }
+            }
+            if (!task)
+                return false;
+            --pending_;
+            task();
+            return true;
+        }
+
+        inline auto ThreadPool::work(std::size_t index) -> void
+        {
+            current() = std::make_pair(this, index);
+            while (!stop_)
+            {
+                if (try_run_one(index))
+                    continue;
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                wake_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+            }
+        }
+
+        template <typename Task>
+        auto ThreadPool::parallel_for(std::size_t count, Task task) -> void
+        {
+            if (!count)
+                return;
+            auto group = std::make_shared<Group>();
+            group->remaining = count;
+            for (std::size_t i = 0; i < count; ++i)
+                push([group, &task, i]()
+                     {
+                         if (!group->failed)
+                             try
+                             {
+                                 task(i);
+                             }
+                             catch (...)
+                             {
+                                 std::lock_guard<std::mutex> lock(group->mutex);
+                                 if (!group->failed.exchange(true))
+                                     group->error = std::current_exception();
+                             }
+                         std::lock_guard<std::mutex> lock(group->mutex);
+                         if (!--group->remaining)
+                             group->done.notify_all();
+                     });
+
+            // Help until nothing is left to take, then wait for tasks still running elsewhere
+            const auto index = self();
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(group->mutex);
+                    if (!group->remaining)
+                        break;
+                }
+                if (!try_run_one(index))
+                    break;
+            }
+            std::unique_lock<std::mutex> lock(group->mutex);
+            group->done.wait(lock, [&group]() { return !group->remaining; });
+            if (group->error)
+                std::rethrow_exception(group->error);
+        }
+
+        template <typename DataType>
+        auto parallel_batch(ThreadPool &pool, const Program<DataType> &program,
+                            const std::vector<Binding<DataType>> &inputs, DataType *out, std::size_t rows,
+                            std::size_t chunk) -> void
+        {
+            const std::size_t tile = Program<DataType>::batch_tile;
+            if (!chunk)
+                chunk = (rows / (pool.size() * 4) + tile - 1) / tile * tile;
+            if (chunk < tile)
+                chunk = tile;
+            pool.parallel_for((rows + chunk - 1) / chunk,
+                              [&](std::size_t task)
+                              {
+                                  const std::size_t begin = task * chunk;
+                                  const std::size_t n = rows - begin < chunk ? rows - begin : chunk;
+                                  std::vector<Binding<DataType>> shifted;
+                                  shifted.reserve(inputs.size());
+                                  for (const auto &input : inputs)
+                                      shifted.push_back(Binding<DataType>{input.slot, input.data + begin,
+                                                                          input.size > begin ? input.size - begin : 0});
+                                  Workspace<DataType> ws;
+                                  program.value_batch(shifted, out + begin, n, ws);
+                              });
+        }
+
+        template <typename DataType>
+        auto parallel_values(ThreadPool &pool, const std::vector<Program<DataType>> &programs, DataType *out,
+                             std::size_t chunk) -> void
+        {
+            const std::size_t count = programs.size();
+            if (!chunk)
+                chunk = count / (pool.size() * 8) + 1;
+            pool.parallel_for((count + chunk - 1) / chunk,
+                              [&](std::size_t task)
+                              {
+                                  const std::size_t end = (task + 1) * chunk < count ? (task + 1) * chunk : count;
+                                  Workspace<DataType> ws;
+                                  for (std::size_t i = task * chunk; i < end; ++i)
+                                      out[i] = programs[i].value(ws);
+                              });
+        }
+
+        template <typename DataType>
+        auto parallel_values(ThreadPool &pool, const std::vector<Program<DataType>> &programs,
+                             const std::vector<Frame<DataType>> &frames, DataType *out, std::size_t chunk) -> void
+        {
+            if (frames.size() < programs.size())
+                throw std::invalid_argument("One frame per program required");
+            const std::size_t count = programs.size();
+            if (!chunk)
+                chunk = count / (pool.size() * 8) + 1;
+            pool.parallel_for((count + chunk - 1) / chunk,
+                              [&](std::size_t task)
+                              {
+                                  const std::size_t end = (task + 1) * chunk < count ? (task + 1) * chunk : count;
+                                  Workspace<DataType> ws;
+                                  for (std::size_t i = task * chunk; i < end; ++i)
+                                      out[i] = programs[i].value(ws, frames[i]);
+                              });
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,246 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_PROFILE_HPP
+#define EVAL_PROFILE_HPP
+
+#include "eval_core.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define EVAL_PROFILE_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define EVAL_PROFILE_TSC 1
+#else
+#define EVAL_PROFILE_TSC 0
+#endif
+
+namespace ydog01
+{
+    namespace core
+    {
+        // Spelling of a builtin in formulas
+        inline auto opcode_name(OpCode code) -> const char *
+        {
+            switch (code)
+            {
+            case OpCode::Add: return "+";
+            case OpCode::Sub: return "-";
+            case OpCode::Mul: return "*";
+            case OpCode::Div: return "/";
+            case OpCode::Mod: return "%";
+            case OpCode::Pow: return "^";
+            case OpCode::Pos: return "+x";
+            case OpCode::Neg: return "-x";
+            case OpCode::Sin: return "sin";
+            case OpCode::Cos: return "cos";
+            case OpCode::Tan: return "tan";
+            case OpCode::Asin: return "asin";
+            case OpCode::Acos: return "acos";
+            case OpCode::Atan: return "atan";
+            case OpCode::Atan2: return "atan2";
+            case OpCode::Sinh: return "sinh";
+            case OpCode::Cosh: return "cosh";
+            case OpCode::Tanh: return "tanh";
+            case OpCode::Asinh: return "asinh";
+            case OpCode::Acosh: return "acosh";
+            case OpCode::Atanh: return "atanh";
+            case OpCode::Exp: return "exp";
+            case OpCode::Exp2: return "exp2";
+            case OpCode::Ln: return "ln";
+            case OpCode::Log: return "log";
+            case OpCode::Log10: return "log10";
+            case OpCode::Log2: return "log2";
+            case OpCode::Log1p: return "log1p";
+            case OpCode::Sqrt: return "sqrt";
+            case OpCode::Cbrt: return "cbrt";
+            case OpCode::Hypot: return "hypot";
+            case OpCode::Ceil: return "ceil";
+            case OpCode::Floor: return "floor";
+            case OpCode::Round: return "round";
+            case OpCode::Trunc: return "trunc";
+            case OpCode::Abs: return "abs";
+            case OpCode::Erf: return "erf";
+            case OpCode::Erfc: return "erfc";
+            case OpCode::Tgamma: return "tgamma";
+            case OpCode::Lgamma: return "lgamma";
+            default: return "user";
+            }
+        }
+
+        // Profiling policy recording calls, elapsed ticks and exceptions per operator instruction.
+        // Pass it to Program::value(ws, profiler), Expression::value(profiler) or
+        // JitProgram::value(ws, profiler); counters are indexed by instruction (token) position,
+        // so use one Profiler per program. Ticks are TSC cycles on x86, nanoseconds elsewhere.
+        class Profiler
+        {
+        public:
+            struct Counters
+            {
+                std::uint64_t calls = 0;
+                std::uint64_t ticks = 0;
+                std::uint64_t exceptions = 0;
+            };
+
+            class Scope
+            {
+                Profiler &profiler_;
+                std::size_t slot_;
+                std::uint64_t start_;
+                bool done_ = false;
+
+            public:
+                Scope(Profiler &profiler, std::size_t slot) : profiler_(profiler), slot_(slot), start_(now()) {}
+                Scope(const Scope &) = delete;
+                auto operator=(const Scope &) -> Scope & = delete;
+                // Without done() the operator threw
+                ~Scope() { profiler_.record(slot_, now() - start_, !done_); }
+
+                auto done() -> void { done_ = true; }
+            };
+
+            static auto now() -> std::uint64_t;
+            // "cycles" or "ns"
+            static auto unit() -> const char *;
+
+            auto counters() const -> const std::vector<Counters> &;
+            auto reset() -> void;
+
+            // One CSV row per operator instruction: position, name, arguments, calls, ticks,
+            // ticks per call and exceptions. name(const Operator<DataType> &) -> std::string
+            // names user operators, e.g. through Evaluator::operator_name.
+            template <typename DataType>
+            auto dump(std::ostream &out, const Program<DataType> &program) const -> void;
+            template <typename DataType, typename Name>
+            auto dump(std::ostream &out, const Program<DataType> &program, Name name) const -> void;
+            template <typename DataType>
+            auto dump(std::ostream &out, const Expression<DataType, std::shared_ptr> &expression) const -> void;
+            template <typename DataType, typename Name>
+            auto dump(std::ostream &out, const Expression<DataType, std::shared_ptr> &expression, Name name) const
+                -> void;
+
+        private:
+            std::vector<Counters> counters_;
+
+            auto record(std::size_t slot, std::uint64_t ticks, bool failed) -> void;
+            auto row(std::ostream &out, std::size_t slot, const std::string &name, std::size_t arguments) const
+                -> void;
+
+            template <typename DataType>
+            static auto user_name(const Operator<DataType> &) -> std::string
+            {
+                return "user";
+            }
+
+            template <typename DataType, typename Name>
+            static auto describe(const Operator<DataType> &op, OpCode code, Name &name) -> std::string
+            {
+                // A builtin called with another arity runs its std::function, so its code is only on op
+                if (code == OpCode::None)
+                    code = op.code;
+                return code == OpCode::None ? std::string(name(op)) : std::string(opcode_name(code));
+            }
+        };
+
+        inline auto Profiler::now() -> std::uint64_t
+        {
+#if EVAL_PROFILE_TSC
+            return __rdtsc();
+#else
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                  std::chrono::steady_clock::now().time_since_epoch())
+                                                  .count());
+#endif
+        }
+
+        inline auto Profiler::unit() -> const char *
+        {
+            return EVAL_PROFILE_TSC ? "cycles" : "ns";
+        }
+
+        inline auto Profiler::counters() const -> const std::vector<Counters> &
+        {
+            return counters_;
+        }
+
+        inline auto Profiler::reset() -> void
+        {
+            counters_.clear();
+        }
+
+        inline auto Profiler::record(std::size_t slot, std::uint64_t ticks, bool failed) -> void
+        {
+            if (slot >= counters_.size())
+                counters_.resize(slot + 1);
+            auto &counters = counters_[slot];
+            ++counters.calls;
+            counters.ticks += ticks;
+            if (failed)
+                ++counters.exceptions;
+        }
+
+        inline auto Profiler::row(std::ostream &out, std::size_t slot, const std::string &name,
+                                  std::size_t arguments) const -> void
+        {
+            const Counters counters = slot < counters_.size() ? counters_[slot] : Counters();
+            out << slot << ',' << name << ',' << arguments << ',' << counters.calls << ',' << counters.ticks << ','
+                << (counters.calls ? double(counters.ticks) / counters.calls : 0.0) << ',' << counters.exceptions
+                << '\n';
+        }
+
+        template <typename DataType>
+        auto Profiler::dump(std::ostream &out, const Program<DataType> &program) const -> void
+        {
+            dump(out, program, &Profiler::user_name<DataType>);
+        }
+
+        template <typename DataType, typename Name>
+        auto Profiler::dump(std::ostream &out, const Program<DataType> &program, Name name) const -> void
+        {
+            out << "instruction,operator,arguments,calls," << unit() << ',' << unit() << "_per_call,exceptions\n";
+            for (std::size_t i = 0; i < program.code.size(); ++i)
+            {
+                const auto &ins = program.code[i];
+                if (ins.type == TokenType::Operator)
+                    row(out, i, describe(*program.operators[ins.operand], ins.code, name), ins.size);
+            }
+        }
+
+        template <typename DataType>
+        auto Profiler::dump(std::ostream &out, const Expression<DataType, std::shared_ptr> &expression) const -> void
+        {
+            dump(out, expression, &Profiler::user_name<DataType>);
+        }
+
+        template <typename DataType, typename Name>
+        auto Profiler::dump(std::ostream &out, const Expression<DataType, std::shared_ptr> &expression, Name name) const
+            -> void
+        {
+            out << "instruction,operator,arguments,calls," << unit() << ',' << unit() << "_per_call,exceptions\n";
+            auto op = expression.operators.begin();
+            std::size_t position = 0;
+            for (auto token : expression.index)
+            {
+                if (token == TokenType::Operator && op != expression.operators.end())
+                {
+                    row(out, position, describe(*op->first, OpCode::None, name), op->second);
+                    ++op;
+                }
+                ++position;
+            }
+        }
+    }
+}
+
+#endif
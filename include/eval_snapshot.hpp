@@ -0,0 +1,76 @@
+/*
+    C++11 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_SNAPSHOT_HPP
+#define EVAL_SNAPSHOT_HPP
+
+#include "eval_core.hpp"
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace ydog01
+{
+    namespace core
+    {
+        // RCU-style publication of immutable versions. Readers take the current version with
+        // snapshot() and use it without locks for as long as they hold it; a writer copies the
+        // current version, changes the copy and swaps it in atomically. Old versions are freed
+        // when their last reader lets go.
+        //
+        // With T = eval::Evaluator<KeyType, DataType, core::SharedMap> the copy shares the whole
+        // symbol trie and each change copies only the child maps along its path, so readers can
+        // parse (Evaluator::parse is const) while another thread adds or removes symbols.
+        // Variable storage and operator objects are shared by all versions: set_variable and
+        // set_derivative show up in every version, as they would for programs already parsed.
+        template <typename T>
+        class Published
+        {
+            std::shared_ptr<const T> current_;
+            std::mutex writer_;
+
+        public:
+            explicit Published(T value);
+            Published(const Published &) = delete;
+            auto operator=(const Published &) -> Published & = delete;
+
+            // The current version; it stays unchanged however long the caller holds it
+            auto snapshot() const -> std::shared_ptr<const T>;
+
+            // Applies fn(T &) to a copy of the current version and publishes the copy. Writers
+            // are serialized; readers never wait. If fn throws nothing is published.
+            template <typename Fn>
+            auto update(Fn fn) -> std::shared_ptr<const T>;
+        };
+
+        template <typename T>
+        Published<T>::Published(T value) : current_(std::make_shared<const T>(std::move(value)))
+        {
+        }
+
+        template <typename T>
+        auto Published<T>::snapshot() const -> std::shared_ptr<const T>
+        {
+            return std::atomic_load(&current_);
+        }
+
+        template <typename T>
+        template <typename Fn>
+        auto Published<T>::update(Fn fn) -> std::shared_ptr<const T>
+        {
+            std::lock_guard<std::mutex> lock(writer_);
+            // current_ keeps the old version alive meanwhile, so every map the copy shares with
+            // it is seen as shared and detached before the first write
+            auto next = std::make_shared<T>(*current_);
+            fn(*next);
+            std::shared_ptr<const T> published(std::move(next));
+            std::atomic_store(&current_, published);
+            return published;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,616 @@
+/*
+    C++17 header only
+    github:https://github.com/ydog01/cxx_eval
+    2026/10/16 -- version 1.0
+*/
+
+#ifndef EVAL_STATIC_HPP
+#define EVAL_STATIC_HPP
+
+#if __cplusplus < 201703L && !(defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#error "eval_static.hpp requires C++17"
+#endif
+
+#include "eval_core.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ydog01
+{
+    namespace core
+    {
+        // Compile-time front end for the builtin grammar of Evaluator<char, DataType>(Options::All).
+        // Parsing follows ParserContext::run step for step, so precedence quirks such as -x^2 == (-x)^2
+        // carry over. Results match the interpreter bit for bit as long as the compiler does not
+        // contract a*b+c into an fma (-ffp-contract=off, or any target without FMA).
+
+        struct StaticOperator
+        {
+            const char *name;
+            OpCode code;
+            int precedence;
+            bool right;
+        };
+
+        inline constexpr StaticOperator static_prefix[] = {
+            {"+", OpCode::Pos, 40, true},
+            {"-", OpCode::Neg, 40, true},
+            {"sin", OpCode::Sin, std::numeric_limits<int>::max(), true},
+            {"cos", OpCode::Cos, std::numeric_limits<int>::max(), true},
+            {"tan", OpCode::Tan, std::numeric_limits<int>::max(), true},
+            {"asin", OpCode::Asin, std::numeric_limits<int>::max(), true},
+            {"acos", OpCode::Acos, std::numeric_limits<int>::max(), true},
+            {"atan", OpCode::Atan, std::numeric_limits<int>::max(), true},
+            {"atan2", OpCode::Atan2, std::numeric_limits<int>::max(), true},
+            {"sinh", OpCode::Sinh, std::numeric_limits<int>::max(), true},
+            {"cosh", OpCode::Cosh, std::numeric_limits<int>::max(), true},
+            {"tanh", OpCode::Tanh, std::numeric_limits<int>::max(), true},
+            {"asinh", OpCode::Asinh, std::numeric_limits<int>::max(), true},
+            {"acosh", OpCode::Acosh, std::numeric_limits<int>::max(), true},
+            {"atanh", OpCode::Atanh, std::numeric_limits<int>::max(), true},
+            {"exp", OpCode::Exp, std::numeric_limits<int>::max(), true},
+            {"exp2", OpCode::Exp2, std::numeric_limits<int>::max(), true},
+            {"ln", OpCode::Ln, std::numeric_limits<int>::max(), true},
+            {"log", OpCode::Log, std::numeric_limits<int>::max(), true},
+            {"log10", OpCode::Log10, std::numeric_limits<int>::max(), true},
+            {"log2", OpCode::Log2, std::numeric_limits<int>::max(), true},
+            {"log1p", OpCode::Log1p, std::numeric_limits<int>::max(), true},
+            {"sqrt", OpCode::Sqrt, std::numeric_limits<int>::max(), true},
+            {"cbrt", OpCode::Cbrt, std::numeric_limits<int>::max(), true},
+            {"hypot", OpCode::Hypot, std::numeric_limits<int>::max(), true},
+            {"ceil", OpCode::Ceil, std::numeric_limits<int>::max(), true},
+            {"floor", OpCode::Floor, std::numeric_limits<int>::max(), true},
+            {"round", OpCode::Round, std::numeric_limits<int>::max(), true},
+            {"trunc", OpCode::Trunc, std::numeric_limits<int>::max(), true},
+            {"abs", OpCode::Abs, std::numeric_limits<int>::max(), true},
+            {"erf", OpCode::Erf, std::numeric_limits<int>::max(), true},
+            {"erfc", OpCode::Erfc, std::numeric_limits<int>::max(), true},
+            {"tgamma", OpCode::Tgamma, std::numeric_limits<int>::max(), true},
+            {"lgamma", OpCode::Lgamma, std::numeric_limits<int>::max(), true},
+        };
+
+        inline constexpr StaticOperator static_infix[] = {
+            {"+", OpCode::Add, 10, false}, {"-", OpCode::Sub, 10, false}, {"*", OpCode::Mul, 20, false},
+            {"/", OpCode::Div, 20, false}, {"%", OpCode::Mod, 20, false}, {"^", OpCode::Pow, 30, true},
+        };
+
+        enum class StaticLiteralKind : std::uint8_t
+        {
+            Exact,//converted at compile time
+            Text,//converted by parse_number once, at construction
+            Pi,
+            E
+        };
+
+        template <typename DataType>
+        struct StaticLiteral
+        {
+            StaticLiteralKind kind = StaticLiteralKind::Exact;
+            DataType value = 0;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            std::size_t slot = 0;//index among the literals resolved at construction
+        };
+
+        struct StaticNode
+        {
+            TokenType type = TokenType::Constant;
+            OpCode code = OpCode::None;
+            std::size_t size = 0;
+            std::size_t operand = 0;//parameter index for variables, literal index for constants
+            std::size_t kids[2] = {0, 0};
+        };
+
+        // Operator stack entry of the compile-time shunting yard
+        struct StaticEntry
+        {
+            enum Kind : std::uint8_t
+            {
+                PREFIX,
+                INFIX,
+                PAREN
+            } kind = PREFIX;
+            OpCode code = OpCode::None;
+            int precedence = 0;
+            bool right = false;
+            std::size_t size = 0;
+        };
+
+        // Postfix nodes with child links; the root is nodes[count - 1]
+        template <typename DataType, std::size_t N>
+        struct StaticTree
+        {
+            StaticNode nodes[N] = {};
+            StaticLiteral<DataType> literals[N] = {};
+            std::size_t count = 0;
+            std::size_t literal_count = 0;
+            std::size_t runtime_literals = 0;
+            std::size_t params = 0;
+        };
+
+        constexpr auto static_length(const char *str) -> std::size_t
+        {
+            std::size_t n = 0;
+            while (str[n])
+                ++n;
+            return n;
+        }
+
+        constexpr auto static_match(const char *str, std::size_t pos, const char *name, std::size_t size)
+            -> bool
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                if (str[pos + i] != name[i])
+                    return false;
+            return true;
+        }
+
+        constexpr auto static_hex_digit(char c) -> int
+        {
+            return c >= '0' && c <= '9'   ? c - '0'
+                   : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                   : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                          : -1;
+        }
+
+        // End of the literal starting at pos, pos when there is none; the grammar of scan_number
+        constexpr auto static_scan_number(const char *str, std::size_t pos, std::size_t length) -> std::size_t
+        {
+            std::size_t p = pos;
+            bool hex = false;
+            if (length - p > 2 && str[p] == '0' && (str[p + 1] == 'x' || str[p + 1] == 'X') &&
+                (static_hex_digit(str[p + 2]) >= 0 ||
+                 (str[p + 2] == '.' && length - p > 3 && static_hex_digit(str[p + 3]) >= 0)))
+            {
+                hex = true;
+                p += 2;
+            }
+            bool any = false, dot = false;
+            for (; p < length; ++p)
+            {
+                if (str[p] == '.' && !dot)
+                {
+                    dot = true;
+                    continue;
+                }
+                const int d = static_hex_digit(str[p]);
+                if (d < 0 || (!hex && d > 9))
+                    break;
+                any = true;
+            }
+            if (!any)
+                return pos;
+            const char marker = hex ? 'p' : 'e';
+            if (p < length && (str[p] == marker || str[p] == marker - ('a' - 'A')))
+            {
+                std::size_t q = p + 1;
+                if (q < length && (str[q] == '+' || str[q] == '-'))
+                    ++q;
+                if (q < length && str[q] >= '0' && str[q] <= '9')
+                {
+                    while (q < length && str[q] >= '0' && str[q] <= '9')
+                        ++q;
+                    p = q;
+                }
+            }
+            return p;
+        }
+
+        // Literals whose value is exact at compile time: a decimal mantissa and power of ten that are
+        // both exactly representable round once (Clinger's fast path), and a hexadecimal mantissa
+        // scaled into the normal range is exact. Anything else is left to parse_number at
+        // construction, so every literal gets the bits the interpreter gives it.
+        template <typename DataType>
+        constexpr auto static_literal(const char *str, std::size_t begin, std::size_t end) -> StaticLiteral<DataType>
+        {
+            StaticLiteral<DataType> literal;
+            literal.begin = begin;
+            literal.end = end;
+            constexpr int digits = std::numeric_limits<DataType>::digits;
+            constexpr std::uint64_t limit =
+                digits < 64 ? std::uint64_t(1) << digits : std::numeric_limits<std::uint64_t>::max();
+            const bool hex = end - begin > 2 && str[begin] == '0' && (str[begin + 1] == 'x' || str[begin + 1] == 'X');
+            const unsigned base = hex ? 16 : 10;
+            std::uint64_t mantissa = 0;
+            long exponent = 0;
+            bool dot = false;
+            std::size_t i = hex ? begin + 2 : begin;
+            for (; i < end; ++i)
+            {
+                if (str[i] == '.')
+                {
+                    dot = true;
+                    continue;
+                }
+                const int d = static_hex_digit(str[i]);
+                if (d < 0 || (!hex && d > 9))
+                    break;
+                const unsigned digit = static_cast<unsigned>(d);
+                if (mantissa > (limit - digit) / base)
+                {
+                    literal.kind = StaticLiteralKind::Text;
+                    return literal;
+                }
+                mantissa = mantissa * base + digit;
+                if (dot)
+                    exponent -= hex ? 4 : 1;
+            }
+            if (i < end)
+            {
+                bool negative = false;
+                if (str[++i] == '+' || str[i] == '-')
+                    negative = str[i++] == '-';
+                long written = 0;
+                for (; i < end; ++i)
+                    if (written < 100000)
+                        written = written * 10 + (str[i] - '0');
+                exponent += negative ? -written : written;
+            }
+            if (!mantissa)
+                return literal;
+
+            if (hex)
+            {
+                int bits = 0;
+                for (std::uint64_t m = mantissa; m; m >>= 1)
+                    ++bits;
+                if (exponent + bits - 1 < std::numeric_limits<DataType>::min_exponent - 1 ||
+                    exponent + bits > std::numeric_limits<DataType>::max_exponent)
+                {
+                    literal.kind = StaticLiteralKind::Text;
+                    return literal;
+                }
+                DataType value = static_cast<DataType>(mantissa);
+                for (; exponent > 0; --exponent)
+                    value *= 2;
+                for (; exponent < 0; ++exponent)
+                    value /= 2;
+                literal.value = value;
+                return literal;
+            }
+
+            while (exponent < 0 && mantissa % 10 == 0)
+            {
+                mantissa /= 10;
+                ++exponent;
+            }
+            long exact_scale = 0;
+            for (std::uint64_t five = 5; five < limit; five *= 5)
+            {
+                ++exact_scale;
+                if (five > limit / 5)
+                    break;
+            }
+            if (exponent > exact_scale || exponent < -exact_scale)
+            {
+                literal.kind = StaticLiteralKind::Text;
+                return literal;
+            }
+            DataType power = 1;
+            for (long k = 0; k < (exponent < 0 ? -exponent : exponent); ++k)
+                power *= 10;
+            literal.value = exponent < 0 ? static_cast<DataType>(mantissa) / power : static_cast<DataType>(mantissa) * power;
+            return literal;
+        }
+
+        template <typename DataType, std::size_t N>
+        constexpr auto static_emit(StaticTree<DataType, N> &tree, std::size_t *values, std::size_t &depth,
+                                   const StaticEntry &entry) -> void
+        {
+            if (entry.kind == StaticEntry::PAREN)
+                throw std::invalid_argument("Missing right parentheses");
+            if (builtin_arity(entry.code) != entry.size)
+                throw std::invalid_argument("Wrong number of arguments for a builtin");
+            if (depth < entry.size)
+                throw std::invalid_argument("Operator is missing operands");
+            auto &node = tree.nodes[tree.count];
+            node.type = TokenType::Operator;
+            node.code = entry.code;
+            node.size = entry.size;
+            depth -= entry.size;
+            for (std::size_t i = 0; i < entry.size; ++i)
+                node.kids[i] = values[depth + i];
+            values[depth++] = tree.count++;
+        }
+
+        template <typename DataType, std::size_t N>
+        constexpr auto static_push(StaticTree<DataType, N> &tree, std::size_t *values, std::size_t &depth,
+                                   StaticEntry *stack, std::size_t &top, const StaticEntry &entry) -> void
+        {
+            while (top)
+            {
+                const auto &last = stack[top - 1];
+                if (last.kind == StaticEntry::PAREN)
+                    break;
+                if (last.precedence < entry.precedence || (entry.right && last.precedence == entry.precedence))
+                    break;
+                static_emit(tree, values, depth, last);
+                --top;
+            }
+            stack[top++] = entry;
+        }
+
+        // Pops operators down to the innermost '(' and returns the number of arguments it collected
+        template <typename DataType, std::size_t N>
+        constexpr auto static_close(StaticTree<DataType, N> &tree, std::size_t *values, std::size_t &depth,
+                                    StaticEntry *stack, std::size_t &top) -> std::size_t &
+        {
+            while (top && stack[top - 1].kind != StaticEntry::PAREN)
+            {
+                static_emit(tree, values, depth, stack[top - 1]);
+                --top;
+            }
+            if (!top)
+                throw std::invalid_argument("Missing left parentheses");
+            return stack[top - 1].size;
+        }
+
+        // N bounds both the node count and the operator stack; every token takes at least one character
+        template <typename DataType, std::size_t N>
+        constexpr auto static_parse(const char *expr, const char *params) -> StaticTree<DataType, N>
+        {
+            StaticTree<DataType, N> tree;
+            std::size_t param_begin[N] = {}, param_size[N] = {};
+            for (std::size_t pos = 0; params[pos];)
+            {
+                while (params[pos] == ' ' || params[pos] == ',')
+                    ++pos;
+                const std::size_t begin = pos;
+                while (params[pos] && params[pos] != ' ' && params[pos] != ',')
+                    ++pos;
+                if (pos == begin)
+                    break;
+                if (tree.params == N)
+                    throw std::invalid_argument("Too many parameters");
+                param_begin[tree.params] = begin;
+                param_size[tree.params++] = pos - begin;
+            }
+
+            std::size_t values[N] = {};
+            std::size_t depth = 0;
+            StaticEntry stack[N] = {};
+            std::size_t top = 0;
+            bool value_class = true;
+            const std::size_t length = static_length(expr);
+            std::size_t pos = 0;
+            while (true)
+            {
+                while (pos < length &&
+                       (expr[pos] == ' ' || expr[pos] == '\t' || expr[pos] == '\n' || expr[pos] == '\r'))
+                    ++pos;
+                if (pos == length)
+                    break;
+
+                if (value_class)
+                {
+                    const std::size_t end = static_scan_number(expr, pos, length);
+                    if (end != pos)
+                    {
+                        auto &literal = tree.literals[tree.literal_count];
+                        literal = static_literal<DataType>(expr, pos, end);
+                        if (literal.kind == StaticLiteralKind::Text)
+                            literal.slot = tree.runtime_literals++;
+                        tree.nodes[tree.count].operand = tree.literal_count++;
+                        values[depth++] = tree.count++;
+                        value_class = false;
+                        pos = end;
+                        continue;
+                    }
+
+                    // Longest match; on a tie prefix operators win over parameters, parameters over constants
+                    std::size_t best = 0;
+                    int kind = 0;
+                    std::size_t which = 0;
+                    if (expr[pos] == '(')
+                        best = 1, kind = 1;
+                    for (std::size_t i = 0; i < sizeof(static_prefix) / sizeof(static_prefix[0]); ++i)
+                    {
+                        const std::size_t size = static_length(static_prefix[i].name);
+                        if (size > best && pos + size <= length && static_match(expr, pos, static_prefix[i].name, size))
+                            best = size, kind = 2, which = i;
+                    }
+                    for (std::size_t i = 0; i < tree.params; ++i)
+                        if (param_size[i] > best && pos + param_size[i] <= length &&
+                            static_match(expr, pos, params + param_begin[i], param_size[i]))
+                            best = param_size[i], kind = 3, which = i;
+                    if (2 > best && pos + 2 <= length && static_match(expr, pos, "pi", 2))
+                        best = 2, kind = 4;
+                    if (1 > best && expr[pos] == 'e')
+                        best = 1, kind = 5;
+
+                    if (!kind)
+                        throw std::invalid_argument("No valid operator or variable found in expression path");
+                    pos += best;
+                    if (kind == 1)
+                        static_push(tree, values, depth, stack, top,
+                                    {StaticEntry::PAREN, OpCode::None, std::numeric_limits<int>::max(), true, 1});
+                    else if (kind == 2)
+                        static_push(tree, values, depth, stack, top,
+                                    {StaticEntry::PREFIX, static_prefix[which].code, static_prefix[which].precedence,
+                                     static_prefix[which].right, 1});
+                    else
+                    {
+                        auto &node = tree.nodes[tree.count];
+                        if (kind == 3)
+                        {
+                            node.type = TokenType::Variale;
+                            node.operand = which;
+                        }
+                        else
+                        {
+                            auto &literal = tree.literals[tree.literal_count];
+                            literal.kind = kind == 4 ? StaticLiteralKind::Pi : StaticLiteralKind::E;
+                            literal.slot = tree.runtime_literals++;
+                            node.operand = tree.literal_count++;
+                        }
+                        values[depth++] = tree.count++;
+                        value_class = false;
+                    }
+                }
+                else if (expr[pos] == ')')
+                {
+                    ++pos;
+                    const std::size_t size = static_close(tree, values, depth, stack, top);
+                    --top;
+                    if (top && stack[top - 1].kind == StaticEntry::PREFIX)
+                        stack[top - 1].size = size;
+                }
+                else if (expr[pos] == ',')
+                {
+                    ++pos;
+                    ++static_close(tree, values, depth, stack, top);
+                    value_class = true;
+                }
+                else
+                {
+                    std::size_t which = sizeof(static_infix) / sizeof(static_infix[0]);
+                    for (std::size_t i = 0; i < sizeof(static_infix) / sizeof(static_infix[0]); ++i)
+                        if (expr[pos] == static_infix[i].name[0])
+                            which = i;
+                    if (which == sizeof(static_infix) / sizeof(static_infix[0]))
+                        throw std::invalid_argument("No valid operator or variable found in expression path");
+                    ++pos;
+                    static_push(tree, values, depth, stack, top,
+                                {StaticEntry::INFIX, static_infix[which].code, static_infix[which].precedence,
+                                 static_infix[which].right, 2});
+                    value_class = true;
+                }
+            }
+            while (top)
+                static_emit(tree, values, depth, stack[--top]);
+            if (depth != 1)
+                throw std::invalid_argument("Expression must leave exactly one value");
+            return tree;
+        }
+
+        template <OpCode Code, typename DataType>
+        inline auto static_unary(DataType x) -> DataType
+        {
+            if constexpr (Code == OpCode::Pos) return +x;
+            else if constexpr (Code == OpCode::Neg) return -x;
+            else if constexpr (Code == OpCode::Sin) return std::sin(x);
+            else if constexpr (Code == OpCode::Cos) return std::cos(x);
+            else if constexpr (Code == OpCode::Tan) return std::tan(x);
+            else if constexpr (Code == OpCode::Asin) return std::asin(x);
+            else if constexpr (Code == OpCode::Acos) return std::acos(x);
+            else if constexpr (Code == OpCode::Atan) return std::atan(x);
+            else if constexpr (Code == OpCode::Sinh) return std::sinh(x);
+            else if constexpr (Code == OpCode::Cosh) return std::cosh(x);
+            else if constexpr (Code == OpCode::Tanh) return std::tanh(x);
+            else if constexpr (Code == OpCode::Asinh) return std::asinh(x);
+            else if constexpr (Code == OpCode::Acosh) return std::acosh(x);
+            else if constexpr (Code == OpCode::Atanh) return std::atanh(x);
+            else if constexpr (Code == OpCode::Exp) return std::exp(x);
+            else if constexpr (Code == OpCode::Exp2) return std::exp2(x);
+            else if constexpr (Code == OpCode::Ln) return std::log(x);
+            else if constexpr (Code == OpCode::Log10) return std::log10(x);
+            else if constexpr (Code == OpCode::Log2) return std::log2(x);
+            else if constexpr (Code == OpCode::Log1p) return std::log1p(x);
+            else if constexpr (Code == OpCode::Sqrt) return std::sqrt(x);
+            else if constexpr (Code == OpCode::Cbrt) return std::cbrt(x);
+            else if constexpr (Code == OpCode::Ceil) return std::ceil(x);
+            else if constexpr (Code == OpCode::Floor) return std::floor(x);
+            else if constexpr (Code == OpCode::Round) return std::round(x);
+            else if constexpr (Code == OpCode::Trunc) return std::trunc(x);
+            else if constexpr (Code == OpCode::Abs) return std::abs(x);
+            else if constexpr (Code == OpCode::Erf) return std::erf(x);
+            else if constexpr (Code == OpCode::Erfc) return std::erfc(x);
+            else if constexpr (Code == OpCode::Tgamma) return std::tgamma(x);
+            else return std::lgamma(x);
+        }
+
+        template <OpCode Code, typename DataType>
+        inline auto static_binary(DataType x, DataType y) -> DataType
+        {
+            if constexpr (Code == OpCode::Add) return x + y;
+            else if constexpr (Code == OpCode::Sub) return x - y;
+            else if constexpr (Code == OpCode::Mul) return x * y;
+            else if constexpr (Code == OpCode::Div) return x / y;
+            else if constexpr (Code == OpCode::Mod) return std::fmod(x, y);
+            else if constexpr (Code == OpCode::Pow) return std::pow(x, y);
+            else if constexpr (Code == OpCode::Atan2) return std::atan2(x, y);
+            else if constexpr (Code == OpCode::Log) return std::log(y) / std::log(x);
+            else return std::hypot(x, y);
+        }
+    }
+
+    namespace eval
+    {
+        // A formula parsed while compiling. Expr and Params must be char arrays with static storage;
+        // Params lists the variable names, separated by commas, in the order operator() takes them:
+        //   static constexpr char f[] = "a*x^2+sin(x)", p[] = "x,a";
+        //   StaticExpression<double, f, p> expr;
+        //   double y = expr(0.5, 2.0);
+        template <typename DataType, const char *Expr, const char *Params>
+        class StaticExpression
+        {
+            static_assert(std::is_floating_point<DataType>::value, "StaticExpression needs a floating-point type");
+
+            static constexpr std::size_t capacity = core::static_length(Expr) + 1;
+            static constexpr auto tree = core::static_parse<DataType, capacity>(Expr, Params);
+
+            DataType literals_[tree.runtime_literals + 1] = {};
+
+            template <std::size_t I>
+            auto node(const DataType *args) const -> DataType;
+
+        public:
+            static constexpr std::size_t arity = tree.params;
+
+            StaticExpression();
+
+            template <typename... Args>
+            auto operator()(const Args &...args) const -> DataType;
+        };
+
+        template <typename DataType, const char *Expr, const char *Params>
+        StaticExpression<DataType, Expr, Params>::StaticExpression()
+        {
+            for (std::size_t i = 0; i < tree.literal_count; ++i)
+            {
+                const auto &literal = tree.literals[i];
+                if (literal.kind == core::StaticLiteralKind::Pi)
+                    literals_[literal.slot] = std::acos(DataType(-1));
+                else if (literal.kind == core::StaticLiteralKind::E)
+                    literals_[literal.slot] = std::exp(DataType(1));
+                else if (literal.kind == core::StaticLiteralKind::Text)
+                    core::parse_number(Expr + literal.begin, Expr + literal.end, literals_[literal.slot]);
+            }
+        }
+
+        template <typename DataType, const char *Expr, const char *Params>
+        template <typename... Args>
+        auto StaticExpression<DataType, Expr, Params>::operator()(const Args &...args) const -> DataType
+        {
+            static_assert(sizeof...(Args) == arity, "Argument count must match the parameter list");
+            const DataType values[sizeof...(Args) + 1] = {static_cast<DataType>(args)...};
+            return node<tree.count - 1>(values);
+        }
+
+        template <typename DataType, const char *Expr, const char *Params>
+        template <std::size_t I>
+        auto StaticExpression<DataType, Expr, Params>::node(const DataType *args) const -> DataType
+        {
+            constexpr core::StaticNode current = tree.nodes[I];
+            if constexpr (current.type == core::TokenType::Variale)
+                return args[current.operand];
+            else if constexpr (current.type == core::TokenType::Constant)
+            {
+                constexpr auto literal = tree.literals[current.operand];
+                if constexpr (literal.kind == core::StaticLiteralKind::Exact)
+                    return literal.value;
+                else
+                    return literals_[literal.slot];
+            }
+            else if constexpr (current.size == 1)
+                return core::static_unary<current.code>(node<current.kids[0]>(args));
+            else
+                return core::static_binary<current.code>(node<current.kids[0]>(args), node<current.kids[1]>(args));
+        }
+    }
+}
+
+#endif
@@ -13,7 +13,11 @@ namespace ydog01
         BuiltinOps = 16,
         BuiltinConstants = 32,
         BuiltinFuncs = 64,
-        All = 127
+        ConstantFolding = 128,
+        CommonSubexpressions = 256,
+        StrengthReduction = 512,//not in All: multiply chains and Horner round differently from pow
+        FastMath = 1024,//with StrengthReduction, also divide by a constant as multiply by its reciprocal
+        All = 511
     };
 
     inline Options operator|(Options a, Options b)